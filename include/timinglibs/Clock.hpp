@@ -0,0 +1,147 @@
+/**
+ * @file Clock.hpp Clock, SystemClock and VirtualClock Classes
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCK_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCK_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Clock is the source of host time for the timestamp
+ * estimators: a system (wall-clock) time, a steady (monotonic) time,
+ * and ways to sleep and wait on the steady time.
+ *
+ * SystemClock is the real thing. VirtualClock only moves when it is
+ * told to, so that estimators can be driven through simulated time
+ * deterministically and much faster than real time.
+ **/
+class Clock
+{
+public:
+  using Listener = std::function<void()>;
+
+  virtual ~Clock() = default;
+
+  /**
+     Time since the epoch in ns. May step forwards or backwards
+  */
+  virtual int64_t system_time_ns() const = 0;
+
+  /**
+     Monotonic time in ns, from an arbitrary origin
+  */
+  virtual int64_t steady_time_ns() const = 0;
+
+  virtual void sleep_for(std::chrono::nanoseconds duration) const = 0;
+
+  /**
+     Wait on cv until it is notified, or until steady_time_ns() reaches
+     deadline. Clocks whose time does not pass by itself can only end
+     the wait by notifying cv, so the owner of cv has to register a
+     listener that does that.
+  */
+  virtual void wait_until(std::condition_variable& cv,
+                          std::unique_lock<std::mutex>& lk,
+                          int64_t steady_deadline_ns) const = 0;
+
+  /**
+     Register listener to be called whenever the time changes other
+     than by passing on its own. Returns an id for remove_listener(),
+     which waits for a running call of the listener to return.
+     Listeners must not add or remove listeners.
+  */
+  virtual size_t add_listener(Listener listener) = 0;
+  virtual void remove_listener(size_t id) = 0;
+};
+
+/**
+ * @brief SystemClock reads std::chrono::system_clock and
+ * std::chrono::steady_clock. Its time passes by itself, so listeners
+ * are never called.
+ **/
+class SystemClock : public Clock
+{
+public:
+  /**
+     The instance shared by everything that uses real time
+  */
+  static std::shared_ptr<SystemClock> get();
+
+  int64_t system_time_ns() const override;
+  int64_t steady_time_ns() const override;
+  void sleep_for(std::chrono::nanoseconds duration) const override;
+  void wait_until(std::condition_variable& cv,
+                  std::unique_lock<std::mutex>& lk,
+                  int64_t steady_deadline_ns) const override;
+
+  size_t add_listener(Listener /*listener*/) override { return 0; }
+  void remove_listener(size_t /*id*/) override {}
+};
+
+/**
+ * @brief VirtualClock is a Clock whose time only changes when
+ * advance() or step_system_time() is called. Threads sleeping or
+ * waiting on it are woken as soon as the time they wait for is reached.
+ **/
+class VirtualClock : public Clock
+{
+public:
+  explicit VirtualClock(int64_t system_time_ns, int64_t steady_time_ns = 0);
+
+  VirtualClock(const VirtualClock&) = delete;            ///< VirtualClock is not copy-constructible
+  VirtualClock& operator=(const VirtualClock&) = delete; ///< VirtualClock is not copy-assignable
+
+  int64_t system_time_ns() const override { return m_system_time_ns.load(); }
+  int64_t steady_time_ns() const override { return m_steady_time_ns.load(); }
+  void sleep_for(std::chrono::nanoseconds duration) const override;
+  void wait_until(std::condition_variable& cv,
+                  std::unique_lock<std::mutex>& lk,
+                  int64_t steady_deadline_ns) const override;
+
+  size_t add_listener(Listener listener) override;
+  void remove_listener(size_t id) override;
+
+  /**
+     Move both the system and the steady time forward by duration
+  */
+  void advance(std::chrono::nanoseconds duration);
+
+  /**
+     Step the system time alone, as NTP or an operator might
+  */
+  void step_system_time(std::chrono::nanoseconds step);
+
+private:
+  void notify();
+
+  std::atomic<int64_t> m_system_time_ns;
+  std::atomic<int64_t> m_steady_time_ns;
+
+  // For sleep_for()
+  mutable std::mutex m_sleep_mutex;
+  mutable std::condition_variable m_sleep_cv;
+
+  std::mutex m_listener_mutex;
+  std::map<size_t, Listener> m_listeners;
+  size_t m_next_listener_id{ 1 };
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCK_HPP_
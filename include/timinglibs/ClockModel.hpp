@@ -0,0 +1,113 @@
+/**
+ * @file ClockModel.hpp ClockModel Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODEL_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODEL_HPP_
+
+#include "dfmessages/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief ClockModelSnapshot is a self-contained description of the
+ * mapping from host time to DAQ time produced by ClockModel.
+ *
+ * Between anchor_host_time and slew_end_host_time the DAQ time advances
+ * at slew_rate_hz, afterwards at rate_hz. When no slew is in progress
+ * the two times are equal. Host times are in ns.
+ **/
+struct ClockModelSnapshot
+{
+  bool valid{ false };
+  int64_t anchor_host_time{ 0 };
+  dfmessages::timestamp_t anchor_daq_time{ dfmessages::TypeDefaults::s_invalid_timestamp };
+  int64_t slew_end_host_time{ 0 };
+  double slew_rate_hz{ 0. };
+  double rate_hz{ 0. };
+  double slew_correction{ 0. };  // ticks still to be absorbed by the slew, at the anchor
+  double error_at_anchor{ 0. };  // ticks
+  double rate_error_hz{ 0. };
+
+  dfmessages::timestamp_t predict(int64_t host_time) const;
+  dfmessages::timestamp_t error_bound(int64_t host_time) const;
+
+  // The inverse of predict(): the host time (ns) at which daq_time is reached
+  int64_t host_time_for(dfmessages::timestamp_t daq_time) const;
+};
+
+/**
+ * @brief ClockModel fits DAQ time against host time over a sliding
+ * window of (daq_time, host_time) pairs, e.g. from TimeSync messages.
+ *
+ * The fit is a least-squares straight line, refitted once without the
+ * outliers of the first pass, so both the offset and the rate of the
+ * DAQ clock with respect to the host clock are tracked. When a new fit
+ * disagrees with the current prediction, the difference is slewed out
+ * over time instead of being applied as a jump, unless it is larger
+ * than s_max_slew_correction seconds' worth of ticks.
+ *
+ * ClockModel is not thread-safe.
+ **/
+class ClockModel
+{
+public:
+  explicit ClockModel(uint64_t nominal_clock_frequency_hz, size_t window_size = 64); // NOLINT(build/unsigned)
+
+  /**
+     Add a pair of DAQ time and the host time (ns) it corresponds to,
+     and refit. now is the current host time (ns), from which the new
+     model takes over from the old one.
+
+     Returns the residual of the new point with respect to the model
+     before the update, in ticks (0 if there was no model yet).
+  */
+  int64_t add_point(dfmessages::timestamp_t daq_time, int64_t host_time, int64_t now);
+
+  const ClockModelSnapshot& get_snapshot() const { return m_snapshot; }
+
+  size_t get_number_of_points() const { return m_points.size(); }
+
+  void reset();
+
+  // Largest fractional deviation of the fitted rate from nominal that we accept
+  static constexpr double s_max_rate_deviation = 1e-3;
+  // Rate uncertainty assumed while there are too few points to fit the rate
+  static constexpr double s_default_rate_uncertainty = 1e-4;
+  // Minimum host time span [s] of the window before the rate is fitted
+  static constexpr double s_min_rate_fit_span = 0.2;
+  // Largest fractional change of the rate used to slew out a correction
+  static constexpr double s_max_slew_fraction = 1e-2;
+  // Corrections larger than this [s] are applied as a jump
+  static constexpr double s_max_slew_correction = 0.1;
+  // Number of standard deviations quoted as the error bound
+  static constexpr double s_error_bound_sigmas = 3.;
+
+private:
+  struct Point
+  {
+    dfmessages::timestamp_t daq_time;
+    int64_t host_time;
+  };
+
+  void fit(int64_t now);
+
+  double m_nominal_clock_frequency_hz;
+  size_t m_window_size;
+  std::deque<Point> m_points;
+  ClockModelSnapshot m_snapshot;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODEL_HPP_
@@ -0,0 +1,66 @@
+/**
+ * @file ClockModelEstimatorBase.hpp ClockModelEstimatorBase Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODELESTIMATORBASE_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODELESTIMATORBASE_HPP_
+
+#include "timinglibs/ClockModel.hpp"
+#include "timinglibs/TimestampEstimatorBase.hpp"
+
+#include "dfmessages/Types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief ClockModelEstimatorBase is the base class for timestamp
+ * estimators which extrapolate a ClockModelSnapshot, however they get
+ * it: TimestampEstimator, TimestampEstimatorHardware and
+ * TimestampEstimatorSharedMemory.
+ *
+ * The estimate never goes backwards: if the model would give less than
+ * an estimate which was already handed out, that one is given again.
+ **/
+class ClockModelEstimatorBase : public TimestampEstimatorBase
+{
+public:
+  explicit ClockModelEstimatorBase(std::shared_ptr<Clock> clock = nullptr);
+
+  dfmessages::timestamp_t get_timestamp_estimate() const override;
+  dfmessages::timestamp_t get_timestamp_estimate_error() const override;
+
+  /**
+     The number of times an estimate was held instead of stepping backwards
+  */
+  uint64_t get_refused_backward_steps() const { return m_refused_backward_steps.load(); } // NOLINT(build/unsigned)
+
+protected:
+  /**
+     The current model, with host times in the Clock's steady time, or
+     an invalid snapshot if there is no model (yet)
+  */
+  virtual ClockModelSnapshot load_snapshot() const = 0;
+
+  bool get_host_time_for_timestamp(dfmessages::timestamp_t ts, int64_t& steady_time_ns) const override;
+
+private:
+  // The largest estimate handed out so far
+  mutable std::atomic<dfmessages::timestamp_t> m_current_timestamp_estimate{
+    dfmessages::TypeDefaults::s_invalid_timestamp
+  };
+  mutable std::atomic<uint64_t> m_refused_backward_steps{ 0 }; // NOLINT(build/unsigned)
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_CLOCKMODELESTIMATORBASE_HPP_
@@ -0,0 +1,149 @@
+/**
+ * @file LogHistogram.hpp LogHistogram Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_LOGHISTOGRAM_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_LOGHISTOGRAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief LogHistogram is a lock-free histogram of unsigned values
+ * (typically latencies in ns) with logarithmically spaced bins.
+ *
+ * Each power of two is split into four sub-bins, so percentiles are
+ * resolved to within 25% of the true value. record() may be called
+ * concurrently with itself and with the readers.
+ **/
+class LogHistogram
+{
+public:
+  static constexpr size_t s_sub_bin_bits = 2;
+  static constexpr size_t s_sub_bins = 1 << s_sub_bin_bits;
+  static constexpr size_t s_number_of_bins = (64 - s_sub_bin_bits + 1) * s_sub_bins;
+
+  LogHistogram() { reset(); }
+
+  LogHistogram(const LogHistogram&) = delete;            ///< LogHistogram is not copy-constructible
+  LogHistogram& operator=(const LogHistogram&) = delete; ///< LogHistogram is not copy-assignable
+
+  void record(uint64_t value) // NOLINT(build/unsigned)
+  {
+    m_bins[bin_index(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t current_max = m_max.load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+    while (value > current_max && !m_max.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  void reset()
+  {
+    for (auto& bin : m_bins)
+      bin.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return m_count.load(std::memory_order_relaxed); } // NOLINT(build/unsigned)
+  uint64_t max() const { return m_max.load(std::memory_order_relaxed); }     // NOLINT(build/unsigned)
+  double mean() const
+  {
+    auto n = count();
+    return n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / n : 0.;
+  }
+
+  /**
+     Value below which a fraction q (0 <= q <= 1) of the recorded
+     values lie, interpolated linearly inside the bin. Returns 0 if
+     nothing has been recorded.
+  */
+  uint64_t percentile(double q) const // NOLINT(build/unsigned)
+  {
+    auto n = count();
+    if (n == 0)
+      return 0;
+    double target = q * n;
+    uint64_t seen = 0; // NOLINT(build/unsigned)
+    for (size_t i = 0; i < s_number_of_bins; ++i) {
+      uint64_t in_bin = m_bins[i].load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+      if (in_bin && seen + in_bin >= target) {
+        double fraction = (target - seen) / in_bin;
+        uint64_t value = bin_lower_edge(i) + static_cast<uint64_t>(fraction * bin_width(i)); // NOLINT(build/unsigned)
+        return value < max() ? value : max();
+      }
+      seen += in_bin;
+    }
+    return max();
+  }
+
+  /**
+     Counts per power of two: element i holds the number of values in
+     [2^(i-1), 2^i), element 0 the number of zeros. Trailing empty bins
+     are dropped.
+  */
+  std::vector<uint64_t> octave_counts() const // NOLINT(build/unsigned)
+  {
+    std::vector<uint64_t> octaves; // NOLINT(build/unsigned)
+    for (size_t i = 0; i < s_number_of_bins; ++i) {
+      uint64_t in_bin = m_bins[i].load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+      size_t octave = bit_width(bin_lower_edge(i));
+      if (octaves.size() <= octave)
+        octaves.resize(octave + 1, 0);
+      octaves[octave] += in_bin;
+    }
+    while (!octaves.empty() && octaves.back() == 0)
+      octaves.pop_back();
+    return octaves;
+  }
+
+private:
+  static size_t bit_width(uint64_t value) // NOLINT(build/unsigned)
+  {
+    return value ? 64 - __builtin_clzll(value) : 0;
+  }
+
+  static size_t bin_index(uint64_t value) // NOLINT(build/unsigned)
+  {
+    if (value < s_sub_bins)
+      return value;
+    size_t msb = bit_width(value) - 1;
+    size_t shift = msb - s_sub_bin_bits;
+    return (msb - s_sub_bin_bits + 1) * s_sub_bins + ((value >> shift) & (s_sub_bins - 1));
+  }
+
+  static uint64_t bin_lower_edge(size_t index) // NOLINT(build/unsigned)
+  {
+    if (index < s_sub_bins)
+      return index;
+    size_t shift = index / s_sub_bins - 1;
+    return (s_sub_bins + index % s_sub_bins) << shift;
+  }
+
+  static uint64_t bin_width(size_t index) // NOLINT(build/unsigned)
+  {
+    return index < s_sub_bins ? 1 : uint64_t(1) << (index / s_sub_bins - 1); // NOLINT(build/unsigned)
+  }
+
+  std::array<std::atomic<uint64_t>, s_number_of_bins> m_bins; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_count;                               // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_sum;                                 // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_max;                                 // NOLINT(build/unsigned)
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_LOGHISTOGRAM_HPP_
@@ -0,0 +1,100 @@
+/**
+ * @file SeqLock.hpp SeqLock Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_SEQLOCK_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief SeqLock holds a small trivially-copyable value which one
+ * writer updates and any number of readers read without locking.
+ *
+ * A reader retries if a write happened while it was copying the
+ * value. The value is stored as an array of lock-free atomic words,
+ * so a SeqLock may also be placed in memory shared between processes.
+ **/
+template<class T>
+class SeqLock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock can only hold trivially copyable types");
+
+public:
+  SeqLock()
+  {
+    for (auto& word : m_words)
+      word.store(0, std::memory_order_relaxed);
+  }
+
+  explicit SeqLock(const T& value)
+    : SeqLock()
+  {
+    store(value);
+  }
+
+  SeqLock(const SeqLock&) = delete;            ///< SeqLock is not copy-constructible
+  SeqLock& operator=(const SeqLock&) = delete; ///< SeqLock is not copy-assignable
+
+  /**
+     Publish a new value. Must not be called concurrently with itself.
+  */
+  void store(const T& value)
+  {
+    std::array<uint64_t, s_number_of_words> buffer{}; // NOLINT(build/unsigned)
+    std::memcpy(buffer.data(), &value, sizeof(T));
+
+    uint64_t sequence = m_sequence.load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < s_number_of_words; ++i)
+      m_words[i].store(buffer[i], std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  T load() const
+  {
+    std::array<uint64_t, s_number_of_words> buffer{}; // NOLINT(build/unsigned)
+    uint64_t before = 0, after = 0;                    // NOLINT(build/unsigned)
+    do {
+      before = m_sequence.load(std::memory_order_acquire);
+      for (size_t i = 0; i < s_number_of_words; ++i)
+        buffer[i] = m_words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = m_sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    T value;
+    std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+    return value;
+  }
+
+  /**
+     Number of completed stores. Changes whenever the value does.
+  */
+  uint64_t get_version() const { return m_sequence.load(std::memory_order_acquire) / 2; } // NOLINT(build/unsigned)
+
+private:
+  static constexpr size_t s_number_of_words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t); // NOLINT
+
+  std::atomic<uint64_t> m_sequence{ 0 };                        // NOLINT(build/unsigned)
+  std::array<std::atomic<uint64_t>, s_number_of_words> m_words; // NOLINT(build/unsigned)
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "SeqLock needs lock-free 64-bit atomics"); // NOLINT
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_SEQLOCK_HPP_
@@ -0,0 +1,122 @@
+/**
+ * @file SharedClockModel.hpp SharedClockModel classes
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_SHAREDCLOCKMODEL_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_SHAREDCLOCKMODEL_HPP_
+
+#include "timinglibs/ClockModel.hpp"
+#include "timinglibs/SeqLock.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief SharedClockModelSegment is the layout of the POSIX shared
+ * memory segment through which a TimestampEstimator publishes its
+ * ClockModelSnapshot to other processes on the same host.
+ *
+ * Host times in the snapshot are steady_clock (CLOCK_MONOTONIC) ns,
+ * which is the same clock in every process. The publisher sets magic
+ * last, so readers must check it, and the version, before trusting the
+ * rest of the segment.
+ **/
+struct SharedClockModelSegment
+{
+  static constexpr uint64_t s_magic = 0x444D'5354'454E'5544; // NOLINT(build/unsigned)
+  static constexpr uint32_t s_version = 1;                   // NOLINT(build/unsigned)
+
+  std::atomic<uint64_t> magic;   // NOLINT(build/unsigned)
+  uint32_t version;              // NOLINT(build/unsigned)
+  uint32_t segment_size;         // NOLINT(build/unsigned)
+  uint64_t clock_frequency_hz;   // NOLINT(build/unsigned)
+  SeqLock<ClockModelSnapshot> snapshot;
+};
+
+/**
+ * @brief SharedClockModelPublisher creates (or re-uses) a shared memory
+ * segment and publishes clock model snapshots to it.
+ *
+ * There must be only one publisher per segment at a time. The segment
+ * is deliberately not removed on destruction, so that readers stay
+ * attached across restarts of the publishing process: a new publisher
+ * carries on in the same segment. A publisher withdraws the model,
+ * i.e. stores an invalid snapshot, when it is destroyed and when it
+ * takes over a segment, so readers never extrapolate from a model that
+ * nobody keeps up to date. A publisher which crashes can't do that.
+ **/
+class SharedClockModelPublisher
+{
+public:
+  /**
+     Throws SharedMemoryIssue if the segment can't be created or mapped
+  */
+  SharedClockModelPublisher(const std::string& shm_name, uint64_t clock_frequency_hz); // NOLINT(build/unsigned)
+  ~SharedClockModelPublisher();
+
+  SharedClockModelPublisher(const SharedClockModelPublisher&) = delete;            ///< not copy-constructible
+  SharedClockModelPublisher& operator=(const SharedClockModelPublisher&) = delete; ///< not copy-assignable
+
+  void publish(const ClockModelSnapshot& snapshot) { m_segment->snapshot.store(snapshot); }
+
+  const std::string& get_name() const { return m_shm_name; }
+
+private:
+  std::string m_shm_name;
+  SharedClockModelSegment* m_segment;
+};
+
+/**
+ * @brief SharedClockModelReader maps a segment written by a
+ * SharedClockModelPublisher read-only.
+ *
+ * The segment may not exist yet when the reader is created: attach()
+ * can be retried until it returns true.
+ **/
+class SharedClockModelReader
+{
+public:
+  SharedClockModelReader(const std::string& shm_name, uint64_t clock_frequency_hz); // NOLINT(build/unsigned)
+  ~SharedClockModelReader();
+
+  SharedClockModelReader(const SharedClockModelReader&) = delete;            ///< not copy-constructible
+  SharedClockModelReader& operator=(const SharedClockModelReader&) = delete; ///< not copy-assignable
+
+  /**
+     Try to map the segment, if that hasn't been done yet. Returns
+     whether the reader is attached. Not thread-safe.
+  */
+  bool attach();
+
+  /**
+     The published snapshot, or an invalid one if not attached
+  */
+  ClockModelSnapshot load() const
+  {
+    const SharedClockModelSegment* segment = m_segment.load(std::memory_order_acquire);
+    return segment ? segment->snapshot.load() : ClockModelSnapshot();
+  }
+
+  const std::string& get_name() const { return m_shm_name; }
+
+private:
+  std::string m_shm_name;
+  uint64_t m_clock_frequency_hz; // NOLINT(build/unsigned)
+  void* m_mapping;
+  size_t m_mapping_size;
+  std::atomic<const SharedClockModelSegment*> m_segment;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_SHAREDCLOCKMODEL_HPP_
@@ -0,0 +1,120 @@
+/**
+ * @file StrandPool.hpp StrandPool Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_STRANDPOOL_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_STRANDPOOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief StrandPool runs tasks on a small pool of worker threads,
+ * grouped into named strands.
+ *
+ * Tasks posted to the same strand run one at a time. Tasks of equal
+ * priority run in the order in which they were posted, and a task
+ * overtakes the waiting tasks of its strand which have a lower priority.
+ * Tasks on different strands may run concurrently; a free worker picks
+ * the strand whose next task has the highest priority, and a strand
+ * goes to the back of the line after each of its tasks, so a long queue
+ * on one strand doesn't hold up the others.
+ *
+ * On top of the n_workers, n_urgent_workers may be started which only
+ * run urgent tasks, i.e. those with at least urgent_priority. An urgent
+ * task then only ever waits for the task that is running on its own
+ * strand, however busy the other workers are.
+ *
+ * Exceptions thrown by a task are reported with ers::error, and do not
+ * stop its strand.
+ **/
+class StrandPool
+{
+public:
+  using task_t = std::function<void()>;
+
+  explicit StrandPool(size_t n_workers,
+                      const std::string& thread_name = "strand-pool",
+                      size_t n_urgent_workers = 0,
+                      int urgent_priority = std::numeric_limits<int>::max());
+
+  /**
+     Runs all the tasks that were already posted, then stops the workers
+  */
+  ~StrandPool();
+
+  StrandPool(const StrandPool&) = delete;            ///< StrandPool is not copy-constructible
+  StrandPool& operator=(const StrandPool&) = delete; ///< StrandPool is not copy-assignable
+  StrandPool(StrandPool&&) = delete;                 ///< StrandPool is not move-constructible
+  StrandPool& operator=(StrandPool&&) = delete;      ///< StrandPool is not move-assignable
+
+  /**
+     Run task after the tasks posted earlier to strand with at least
+     the same priority
+  */
+  void post(const std::string& strand, task_t task, int priority = 0);
+
+  /**
+     Block until every task posted so far has finished
+  */
+  void wait_idle();
+
+  size_t get_number_of_workers() const { return m_workers.size() - m_n_urgent_workers; }
+  size_t get_number_of_urgent_workers() const { return m_n_urgent_workers; }
+  size_t get_number_of_pending_tasks() const;
+
+private:
+  struct Task
+  {
+    int priority;
+    task_t task;
+  };
+
+  struct Strand
+  {
+    // by decreasing priority, then in the order they were posted
+    std::deque<Task> tasks;
+    // true while the strand is waiting in m_ready, or one of its tasks is running
+    bool scheduled{ false };
+  };
+
+  using strand_iterator_t = std::map<std::string, Strand>::iterator;
+
+  void worker_fn(bool urgent_only);
+
+  // the ready strand with the highest priority next task, or m_ready.end() if none is at least min_priority
+  std::deque<strand_iterator_t>::iterator next_ready_strand(int min_priority);
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_idle_cv;
+
+  std::map<std::string, Strand> m_strands;
+  std::deque<strand_iterator_t> m_ready;
+  size_t m_pending_tasks{ 0 };
+  bool m_stop{ false };
+
+  size_t m_n_urgent_workers;
+  int m_urgent_priority;
+  std::vector<std::thread> m_workers;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_STRANDPOOL_HPP_
@@ -0,0 +1,82 @@
+/**
+ * @file TimeSyncSourceTracker.hpp TimeSyncSourceTracker Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESYNCSOURCETRACKER_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESYNCSOURCETRACKER_HPP_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimeSyncSourceTracker keeps track of the TimeSync messages
+ * from each of the sources writing to a TimeSync queue, and decides
+ * which of them are fit to be used for the timestamp estimate.
+ *
+ * Each source's offset is the median residual (daq_time minus the
+ * clock model's prediction) of its last s_residual_window TimeSyncs.
+ * Once at least two sources have enough TimeSyncs to be judged, a
+ * source whose offset disagrees by more than the outlier threshold
+ * with a majority of the sources is an outlier, and its TimeSyncs are
+ * rejected until it agrees again. Sources which have not been judged
+ * yet are accepted only if they agree with the model. If there is no
+ * majority, nothing is rejected.
+ *
+ * TimeSyncSourceTracker is not thread-safe.
+ **/
+class TimeSyncSourceTracker
+{
+public:
+  struct Source
+  {
+    uint64_t received{ 0 }; // NOLINT(build/unsigned)
+    uint64_t rejected{ 0 }; // NOLINT(build/unsigned)
+    int64_t offset{ 0 };        // ticks, median residual
+    int64_t delivery_lag{ 0 };  // ns, from TimeSync system_time to arrival, for the last TimeSync
+    int64_t last_arrival{ 0 };  // host ns
+    bool outlier{ false };
+    std::deque<int64_t> residuals;
+  };
+
+  explicit TimeSyncSourceTracker(int64_t outlier_threshold);
+
+  /**
+     Record a TimeSync from source, with the given residual with respect
+     to the current clock model (ignored if there is no model yet).
+     Returns whether the TimeSync should be used for the clock model.
+  */
+  bool add(pid_t source, int64_t residual, bool have_model, int64_t delivery_lag, int64_t now);
+
+  const std::map<pid_t, Source>& get_sources() const { return m_sources; }
+
+  void reset() { m_sources.clear(); }
+
+  // Number of residuals per source from which its offset is taken
+  static constexpr size_t s_residual_window = 8;
+  // Number of residuals a source needs before it is judged
+  static constexpr size_t s_min_residuals = 3;
+  // Sources not heard from for this long [ns] don't count towards the majority
+  static constexpr int64_t s_source_timeout = 10'000'000'000;
+
+private:
+  void classify(int64_t now);
+
+  int64_t m_outlier_threshold; // ticks
+  std::map<pid_t, Source> m_sources;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESYNCSOURCETRACKER_HPP_
@@ -0,0 +1,200 @@
+/**
+ * @file TimerWheel.hpp TimerWheel Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMERWHEEL_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMERWHEEL_HPP_
+
+#include "dfmessages/Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimerWheel is a hierarchical timer wheel of payloads keyed by
+ * DAQ timestamp.
+ *
+ * Timestamps are grouped into slots of slot_width ticks. Level L of
+ * the wheel has s_slots_per_level slots, each s_slots_per_level^L slots
+ * wide; a timer sits in the lowest level whose slot still separates it
+ * from the current slot, and is cascaded down one or more levels as the
+ * current slot reaches it. Timers beyond the range of the top level wait
+ * in an overflow list. Adding a timer is O(1), and each timer is moved
+ * at most s_levels times before it expires.
+ *
+ * advance() jumps straight to the next slot at which something has to
+ * be cascaded, so large steps of the timestamp cost no more than small
+ * ones. Payloads are only handed out once the timestamp passed to
+ * advance() has reached their expiry, not when their slot is reached.
+ *
+ * TimerWheel is not thread-safe.
+ **/
+template<class Payload>
+class TimerWheel
+{
+public:
+  static constexpr size_t s_slot_bits = 6;
+  static constexpr size_t s_slots_per_level = 1 << s_slot_bits;
+  static constexpr size_t s_levels = 4;
+
+  explicit TimerWheel(uint64_t slot_width) // NOLINT(build/unsigned)
+    : m_slot_width(std::max<uint64_t>(slot_width, 1))
+  {}
+
+  void add(dfmessages::timestamp_t expiry, Payload payload)
+  {
+    insert(Timer{ expiry, std::move(payload) });
+    ++m_size;
+  }
+
+  /**
+     Move the wheel on to now, appending the payloads of all timers
+     with expiry <= now to expired, in no particular order.
+  */
+  void advance(dfmessages::timestamp_t now, std::vector<Payload>& expired)
+  {
+    const uint64_t target = now / m_slot_width; // NOLINT(build/unsigned)
+    while (m_current_slot < target) {
+      m_current_slot = std::min(next_cascade_slot(), target);
+      cascade();
+    }
+
+    auto keep = m_due.begin();
+    for (auto& timer : m_due) {
+      if (timer.expiry <= now) {
+        expired.push_back(std::move(timer.payload));
+        --m_size;
+      } else {
+        *keep++ = std::move(timer);
+      }
+    }
+    m_due.erase(keep, m_due.end());
+  }
+
+  /**
+     A timestamp no later than the earliest expiry: either the expiry
+     itself, or the start of the slot at which the wheel next needs to
+     be advanced to make progress. Only meaningful if !empty().
+  */
+  dfmessages::timestamp_t next_expiry() const
+  {
+    if (!m_due.empty()) {
+      auto earliest = std::min_element(
+        m_due.begin(), m_due.end(), [](const Timer& a, const Timer& b) { return a.expiry < b.expiry; });
+      return earliest->expiry;
+    }
+    return next_cascade_slot() * m_slot_width;
+  }
+
+  /**
+     Remove all the timers, appending their payloads to removed
+  */
+  void clear(std::vector<Payload>& removed)
+  {
+    auto take = [&](std::vector<Timer>& timers) {
+      for (auto& timer : timers)
+        removed.push_back(std::move(timer.payload));
+      timers.clear();
+    };
+    take(m_due);
+    take(m_overflow);
+    for (auto& level : m_levels)
+      for (auto& slot : level)
+        take(slot);
+    m_size = 0;
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+private:
+  struct Timer
+  {
+    dfmessages::timestamp_t expiry;
+    Payload payload;
+  };
+
+  static constexpr uint64_t s_no_slot = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+
+  void insert(Timer&& timer)
+  {
+    const uint64_t slot = timer.expiry / m_slot_width; // NOLINT(build/unsigned)
+    if (slot <= m_current_slot) {
+      m_due.push_back(std::move(timer));
+      return;
+    }
+    // The level is set by the most significant group of slot bits in
+    // which the timer's slot differs from the current one
+    size_t level = (63 - __builtin_clzll(slot ^ m_current_slot)) / s_slot_bits;
+    if (level >= s_levels) {
+      m_overflow.push_back(std::move(timer));
+      return;
+    }
+    m_levels[level][(slot >> (level * s_slot_bits)) & (s_slots_per_level - 1)].push_back(std::move(timer));
+  }
+
+  // The lowest slot after the current one at which a non-empty wheel slot has to be cascaded
+  uint64_t next_cascade_slot() const // NOLINT(build/unsigned)
+  {
+    uint64_t next = s_no_slot; // NOLINT(build/unsigned)
+    for (size_t level = 0; level < s_levels; ++level) {
+      const size_t shift = level * s_slot_bits;
+      const uint64_t rotation_start = (m_current_slot >> (shift + s_slot_bits)) << (shift + s_slot_bits); // NOLINT
+      for (size_t i = 0; i < s_slots_per_level; ++i) {
+        if (m_levels[level][i].empty())
+          continue;
+        // Timers in this level were placed in the current rotation, after the current slot
+        next = std::min(next, rotation_start + (uint64_t(i) << shift)); // NOLINT(build/unsigned)
+      }
+    }
+    for (auto& timer : m_overflow) {
+      const size_t shift = s_levels * s_slot_bits;
+      next = std::min(next, ((timer.expiry / m_slot_width) >> shift) << shift);
+    }
+    return next;
+  }
+
+  // Redistribute the timers whose wheel slot the current slot has just reached
+  void cascade()
+  {
+    std::vector<Timer> moving;
+    if ((m_current_slot & ((uint64_t(1) << (s_levels * s_slot_bits)) - 1)) == 0) { // NOLINT(build/unsigned)
+      moving.swap(m_overflow);
+    }
+    for (size_t level = s_levels; level-- > 0;) {
+      const size_t shift = level * s_slot_bits;
+      if (level > 0 && (m_current_slot & ((uint64_t(1) << shift) - 1)) != 0) // NOLINT(build/unsigned)
+        continue;
+      auto& slot = m_levels[level][(m_current_slot >> shift) & (s_slots_per_level - 1)];
+      std::move(slot.begin(), slot.end(), std::back_inserter(moving));
+      slot.clear();
+    }
+    for (auto& timer : moving)
+      insert(std::move(timer));
+  }
+
+  uint64_t m_slot_width;        // NOLINT(build/unsigned)
+  uint64_t m_current_slot{ 0 }; // NOLINT(build/unsigned)
+  size_t m_size{ 0 };
+  std::array<std::array<std::vector<Timer>, s_slots_per_level>, s_levels> m_levels;
+  std::vector<Timer> m_overflow;
+  std::vector<Timer> m_due; // timers in or before the current slot
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMERWHEEL_HPP_
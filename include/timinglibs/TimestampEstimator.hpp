@@ -9,6 +9,12 @@
 #ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATOR_HPP_
 #define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATOR_HPP_
 
+#include "timinglibs/ClockModel.hpp"
+#include "timinglibs/ClockModelEstimatorBase.hpp"
+#include "timinglibs/LogHistogram.hpp"
+#include "timinglibs/SeqLock.hpp"
+#include "timinglibs/SharedClockModel.hpp"
+#include "timinglibs/TimeSyncSourceTracker.hpp"
 #include "timinglibs/TimestampEstimatorBase.hpp"
 
 #include "timinglibs/TimingIssues.hpp"
@@ -19,7 +25,10 @@
 #include "dfmessages/Types.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
 namespace dunedaq {
@@ -29,26 +38,116 @@ namespace timinglibs {
  * @brief TimestampEstimator is an implementation of
  * TimestampEstimatorBase that uses TimeSync messages from an input
  * queue to estimate the current timestamp
+ *
+ * TimeSync messages are consumed as soon as they arrive and fed to a
+ * ClockModel, which tracks both the offset and the rate of the DAQ
+ * clock with respect to the host clock. Each time the model changes,
+ * a snapshot of it, re-anchored to the host's monotonic clock, is
+ * published through a SeqLock. get_timestamp_estimate() reads the
+ * snapshot without locking and extrapolates it to the time of the
+ * call, so the estimate is tick-accurate for the cost of a clock read.
+ *
+ * The TimeSync queue has one writer per readout process. Sources are
+ * tracked separately by a TimeSyncSourceTracker, and TimeSyncs from a
+ * source which disagrees with the others (e.g. because its host clock
+ * is off) are left out of the model.
+ *
+ * Host times come from the estimator's Clock. With a VirtualClock, and
+ * TimeSyncs fed in directly with add_timesync(), the estimator can be
+ * run through simulated time deterministically.
  **/
-class TimestampEstimator : public TimestampEstimatorBase
+class TimestampEstimator : public ClockModelEstimatorBase
 {
 public:
+  /**
+     Construct a TimestampEstimator which reads from time_sync_source.
+     A non-zero run_number is in force before the first TimeSync is
+     read, see set_run_number()
+  */
   TimestampEstimator(std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>>& time_sync_source,
-                     uint64_t clock_frequency_hz); // NOLINT(build/unsigned)
+                     uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                     std::shared_ptr<Clock> clock = nullptr,
+                     dfmessages::run_number_t run_number = 0);
+
+  /**
+     Construct a TimestampEstimator which reads from its own
+     DAQSource on the queue instance time_sync_queue_name
+  */
+  TimestampEstimator(const std::string& time_sync_queue_name,
+                     uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                     std::shared_ptr<Clock> clock = nullptr,
+                     dfmessages::run_number_t run_number = 0);
+
+  /**
+     Construct a TimestampEstimator which doesn't read TimeSyncs from a
+     queue: they have to be given to it with add_timesync()
+  */
+  TimestampEstimator(uint64_t clock_frequency_hz, std::shared_ptr<Clock> clock); // NOLINT(build/unsigned)
 
   virtual ~TimestampEstimator();
 
-  dfmessages::timestamp_t get_timestamp_estimate() const override { return m_current_timestamp_estimate.load(); }
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
+
+  void set_run_number(dfmessages::run_number_t run_number) override;
+
+  /**
+     Also publish the clock model to the POSIX shared memory segment
+     shm_name, from which TimestampEstimatorSharedMemory instances in
+     other processes can read it. Throws SharedMemoryIssue if the
+     segment can't be set up.
+  */
+  void publish_to_shared_memory(const std::string& shm_name);
+
+  /**
+     Add a TimeSync to the clock model, as if it had just arrived on the queue
+  */
+  void add_timesync(const dfmessages::TimeSync& timesync);
+
+  /**
+     The number of TimeSyncs which were not used: from another run, from
+     the future, or from an outlier source
+  */
+  uint64_t get_discarded_timesyncs() const { return m_discarded_timesyncs.load(); } // NOLINT(build/unsigned)
+
+protected:
+  ClockModelSnapshot load_snapshot() const override { return m_published_snapshot.load(); }
 
 private:
   void estimator_thread_fn(std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>>& time_sync_source);
 
-  // The estimate of the current timestamp
-  std::atomic<dfmessages::timestamp_t> m_current_timestamp_estimate{ dfmessages::TypeDefaults::s_invalid_timestamp };
+  // The fitted model, the state of each TimeSync source, and the TimeSync with the largest daq_time seen so far
+  std::mutex m_clock_model_mutex;
+  ClockModel m_clock_model;
+  TimeSyncSourceTracker m_source_tracker;
+  dfmessages::TimeSync m_most_recent_timesync{ dfmessages::TypeDefaults::s_invalid_timestamp };
+
+  // The current model, with host times in the Clock's steady time
+  SeqLock<ClockModelSnapshot> m_published_snapshot;
+  // Publishes the same model to other processes, if requested. Protected by m_clock_model_mutex
+  std::unique_ptr<SharedClockModelPublisher> m_shared_memory_publisher;
+
+  // Monitoring
+  std::atomic<uint64_t> m_received_timesyncs{ 0 };            // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_discarded_timesyncs{ 0 };           // NOLINT(build/unsigned)
+  std::atomic<int64_t> m_last_timesync_arrival{ 0 };           // steady time, ns
+  std::atomic<size_t> m_model_points{ 0 };
+  LogHistogram m_residual_histogram;        // |estimate - daq_time|, ticks
+  LogHistogram m_residual_ahead_histogram;  // estimate - daq_time where positive, ticks
+  LogHistogram m_residual_behind_histogram; // daq_time - estimate where positive, ticks
+
+  // TimeSyncs from other runs are ignored. 0 means any run
+  std::atomic<dfmessages::run_number_t> m_run_number{ 0 };
 
   std::atomic<bool> m_running_flag{ false };
   uint64_t m_clock_frequency_hz; // NOLINT(build/unsigned)
+  std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>> m_owned_time_sync_source;
   std::thread m_estimator_thread;
+
+  // Sources whose offset from the others is larger than this [s] are outliers
+  static constexpr double s_source_outlier_threshold = 1e-3;
+
+  // How long the estimator thread blocks waiting for a TimeSync before checking whether it should stop
+  static constexpr std::chrono::milliseconds s_timesync_wait_timeout{ 100 };
 };
 
 } // namespace timinglibs
@@ -9,9 +9,20 @@
 #ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORBASE_HPP_
 #define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORBASE_HPP_
 
+#include "timinglibs/Clock.hpp"
+#include "timinglibs/TimerWheel.hpp"
+
 #include "dfmessages/Types.hpp"
+#include "opmonlib/InfoCollector.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace dunedaq {
 namespace timinglibs {
@@ -20,12 +31,57 @@ namespace timinglibs {
  * @brief TimestampEstimatorBase is the base class for timestamp-based
  * logic in test systems where the current timestamp must be estimated
  * somehow (eg, because there is no hardware timing system).
+ *
+ * The wait_for_* functions sleep until the host time at which the
+ * implementation expects the target to be reached, and are woken
+ * early when the implementation's model changes (notify_waiters()) or
+ * when interrupt_waits() is called.
+ *
+ * call_at_timestamp() and async_wait_for_timestamp() do the same
+ * without blocking the caller: all of the pending timestamps are kept
+ * in a TimerWheel served by a single timer thread, which is started on
+ * first use.
+ *
+ * All host times, including the timing of waits, come from a Clock:
+ * the SystemClock by default, or e.g. a VirtualClock to run an
+ * estimator through simulated time.
  **/
 class TimestampEstimatorBase
 {
 public:
+  /**
+     clock defaults to SystemClock::get()
+  */
+  explicit TimestampEstimatorBase(std::shared_ptr<Clock> clock = nullptr);
+
+  TimestampEstimatorBase(const TimestampEstimatorBase&) = delete;            ///< not copy-constructible
+  TimestampEstimatorBase& operator=(const TimestampEstimatorBase&) = delete; ///< not copy-assignable
+
+  virtual ~TimestampEstimatorBase();
+
   virtual dfmessages::timestamp_t get_timestamp_estimate() const = 0;
 
+  /**
+     Bound on the error of the current timestamp estimate, in clock
+     ticks. Implementations which cannot quantify their error return 0.
+     While there is no estimate at all, the error is unbounded, and
+     implementations return s_invalid_timestamp.
+  */
+  virtual dfmessages::timestamp_t get_timestamp_estimate_error() const { return 0; }
+
+  /**
+     Add the implementation's operational monitoring information, if
+     any, to the hosting module's InfoCollector
+  */
+  virtual void get_info(opmonlib::InfoCollector& /*ci*/, int /*level*/) {}
+
+  /**
+     Tell the implementation which run is in progress, so that it can
+     ignore input (e.g. TimeSync messages) left over from other runs.
+     TimeSyncs without a run number are always used, and 0 means any run.
+  */
+  virtual void set_run_number(dfmessages::run_number_t /*run_number*/) {}
+
   enum WaitStatus
   {
     kFinished,
@@ -48,6 +104,75 @@ public:
      Returns kFinished if the timestamp became valid, or kInterrupted if continue_flag became false first
   */
   WaitStatus wait_for_timestamp(dfmessages::timestamp_t ts, std::atomic<bool>& continue_flag);
+
+  /**
+     Wake up all threads in wait_for_* so that they re-check their
+     continue_flag. Call this after setting a continue_flag to false
+     to make the wait return without delay.
+  */
+  void interrupt_waits() { notify_waiters(); }
+
+  using TimestampCallback = std::function<void(WaitStatus)>;
+
+  /**
+     Call callback from the timer thread once the timestamp estimate
+     reaches ts, with kFinished, or with kInterrupted if the estimator
+     is destroyed first. Callbacks must not throw, and should return
+     quickly, since they hold up all the other pending callbacks.
+  */
+  void call_at_timestamp(dfmessages::timestamp_t ts, TimestampCallback callback);
+
+  /**
+     Returns a future which becomes ready with kFinished once the
+     timestamp estimate reaches ts, or with kInterrupted if the
+     estimator is destroyed first
+  */
+  std::future<WaitStatus> async_wait_for_timestamp(dfmessages::timestamp_t ts);
+
+  const Clock& get_clock() const { return *m_clock; }
+
+protected:
+  /**
+     The steady time of the Clock, in ns, at which the estimate is
+     expected to reach ts. Returns false if the implementation cannot
+     tell, in which case waits poll every s_max_wait_interval.
+  */
+  virtual bool get_host_time_for_timestamp(dfmessages::timestamp_t /*ts*/, int64_t& /*steady_time_ns*/) const
+  {
+    return false;
+  }
+
+  /**
+     To be called by implementations whenever their estimate model changes
+  */
+  void notify_waiters();
+
+  /**
+     Stop the timer thread and call the outstanding callbacks with
+     kInterrupted. The timer thread calls get_timestamp_estimate(), so
+     implementations must call this first thing in their destructor.
+  */
+  void stop_async_waits();
+
+  // Longest time a wait sleeps before re-checking its continue_flag
+  static constexpr std::chrono::milliseconds s_max_wait_interval{ 100 };
+
+  // Width in ticks of the finest slots of the timer wheel
+  static constexpr uint64_t s_timer_slot_width = 4096; // NOLINT(build/unsigned)
+
+private:
+  void timer_thread_fn();
+
+  std::shared_ptr<Clock> m_clock;
+  size_t m_clock_listener_id;
+
+  // Protects everything below, and is the mutex of all waits on m_wait_cv
+  std::mutex m_wait_mutex;
+  std::condition_variable m_wait_cv;
+
+  TimerWheel<TimestampCallback> m_timer_wheel{ s_timer_slot_width };
+  bool m_async_waits_stopped{ false };
+  std::thread m_timer_thread;
 };
 
 } // namespace timinglibs
@@ -0,0 +1,128 @@
+/**
+ * @file TimestampEstimatorHardware.hpp TimestampEstimatorHardware Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORHARDWARE_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORHARDWARE_HPP_
+
+#include "timinglibs/ClockModel.hpp"
+#include "timinglibs/ClockModelEstimatorBase.hpp"
+#include "timinglibs/SeqLock.hpp"
+#include "timinglibs/TimestampEstimatorBase.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "dfmessages/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimestampEstimatorHardware is an implementation of
+ * TimestampEstimatorBase that samples the timestamp register of a
+ * timing endpoint on this host.
+ *
+ * Every sample interval, the timestamp is read once (for an endpoint,
+ * a single short IPbus read) and paired with the host time half way
+ * through the read. Samples whose read took much longer than the
+ * fastest recent ones are dropped, since their host time is
+ * uncertain. The samples are fitted by a ClockModel, and
+ * get_timestamp_estimate() interpolates the model between samples,
+ * without touching the hardware.
+ **/
+class TimestampEstimatorHardware : public ClockModelEstimatorBase
+{
+public:
+  /**
+     Reads the current timestamp from the hardware. May throw. A return
+     value of 0 means that the timestamp is not valid yet.
+  */
+  using TimestampReader = std::function<dfmessages::timestamp_t()>;
+
+  /**
+     Sample with reader every sample_interval. If sample_interval is
+     zero, no sampling thread is started, and samples are only taken
+     by calling sample()
+  */
+  TimestampEstimatorHardware(TimestampReader reader,
+                             uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                             std::chrono::milliseconds sample_interval = s_default_sample_interval,
+                             std::shared_ptr<Clock> clock = nullptr);
+
+  virtual ~TimestampEstimatorHardware();
+
+  /**
+     Read the timestamp once and add it to the model. Returns false if
+     the read failed or the sample was dropped
+  */
+  bool sample();
+
+  /**
+     A TimestampReader for endpoint endpoint_id of the design DSGN on the uhal device hw
+  */
+  template<class DSGN, class HW>
+  static TimestampReader endpoint_reader(std::shared_ptr<HW> hw, uint32_t endpoint_id = 0) // NOLINT(build/unsigned)
+  {
+    return [hw, endpoint_id]() {
+      return hw->template getNode<DSGN>("").get_endpoint_node(endpoint_id).read_timestamp();
+    };
+  }
+
+  static constexpr std::chrono::milliseconds s_default_sample_interval{ 100 };
+
+protected:
+  ClockModelSnapshot load_snapshot() const override { return m_published_snapshot.load(); }
+
+private:
+  void sampler_thread_fn();
+
+  TimestampReader m_reader;
+  std::chrono::milliseconds m_sample_interval;
+  std::shared_ptr<Clock> m_clock;
+
+  // Serialises sample(), and protects the model and the round trip history
+  std::mutex m_sample_mutex;
+  ClockModel m_clock_model;
+  std::deque<int64_t> m_recent_round_trips; // ns
+  // Failed reads in a row, and when to warn about them next (steady time, ns)
+  uint64_t m_read_failures{ 0 }; // NOLINT(build/unsigned)
+  int64_t m_next_read_failure_warning{ 0 };
+
+  // The current model, with host times in the Clock's steady time
+  SeqLock<ClockModelSnapshot> m_published_snapshot;
+
+  // Wakes the sampling thread when it has to stop, or the clock jumps
+  std::mutex m_sampler_mutex;
+  std::condition_variable m_sampler_cv;
+  bool m_stop_sampling{ false };
+  size_t m_clock_listener_id{ 0 };
+  std::thread m_sampler_thread;
+
+  // Samples whose read took more than this many times the fastest of
+  // the recent ones, and more than s_round_trip_tolerance, are dropped
+  static constexpr int64_t s_max_round_trip_ratio = 3;
+  static constexpr std::chrono::microseconds s_round_trip_tolerance{ 20 };
+  static constexpr size_t s_round_trip_history = 16;
+
+  // How often failed reads are warned about while they keep failing
+  static constexpr std::chrono::seconds s_read_failure_warning_interval{ 10 };
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORHARDWARE_HPP_
@@ -0,0 +1,70 @@
+/**
+ * @file TimestampEstimatorRegistry.hpp TimestampEstimatorRegistry Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORREGISTRY_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORREGISTRY_HPP_
+
+#include "timinglibs/TimestampEstimator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimestampEstimatorRegistry hands out one TimestampEstimator
+ * per (TimeSync queue, clock frequency) to all the modules of a
+ * process.
+ *
+ * The first get_estimator() call for a queue creates the estimator,
+ * later calls share it, and it is destroyed when the last consumer
+ * drops its pointer. So several timestamp consumers in one application
+ * cost one estimator thread and one pass over the TimeSync traffic.
+ **/
+class TimestampEstimatorRegistry
+{
+public:
+  static TimestampEstimatorRegistry& get();
+
+  TimestampEstimatorRegistry(const TimestampEstimatorRegistry&) = delete; ///< not copy-constructible
+  TimestampEstimatorRegistry& operator=(const TimestampEstimatorRegistry&) = delete; ///< not copy-assignable
+
+  /**
+     The estimator for TimeSyncs from the queue instance
+     time_sync_queue_name, creating it if nobody holds it yet. A
+     non-zero run_number is passed on to the estimator, and a new
+     estimator uses it from its very first TimeSync
+  */
+  std::shared_ptr<TimestampEstimator> get_estimator(const std::string& time_sync_queue_name,
+                                                    uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                                    dfmessages::run_number_t run_number = 0);
+
+  /**
+     The number of estimators currently alive
+  */
+  size_t get_number_of_estimators();
+
+private:
+  TimestampEstimatorRegistry() = default;
+
+  using key_t = std::pair<std::string, uint64_t>; // NOLINT(build/unsigned)
+
+  std::mutex m_mutex;
+  std::map<key_t, std::weak_ptr<TimestampEstimator>> m_estimators;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORREGISTRY_HPP_
@@ -0,0 +1,60 @@
+/**
+ * @file TimestampEstimatorSharedMemory.hpp TimestampEstimatorSharedMemory Class
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSHAREDMEMORY_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSHAREDMEMORY_HPP_
+
+#include "timinglibs/ClockModelEstimatorBase.hpp"
+#include "timinglibs/SharedClockModel.hpp"
+
+#include "dfmessages/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimestampEstimatorSharedMemory is an implementation of
+ * TimestampEstimatorBase that extrapolates the clock model published
+ * by a TimestampEstimator in another process (see
+ * TimestampEstimator::publish_to_shared_memory()).
+ *
+ * Reading the model is lock-free, so get_timestamp_estimate() costs
+ * about as much as it does in the publishing process. Until the
+ * segment has been published, the estimate is invalid, and attaching
+ * to it is retried at most every s_attach_retry_interval.
+ **/
+class TimestampEstimatorSharedMemory : public ClockModelEstimatorBase
+{
+public:
+  TimestampEstimatorSharedMemory(const std::string& shm_name, uint64_t clock_frequency_hz); // NOLINT(build/unsigned)
+
+  virtual ~TimestampEstimatorSharedMemory();
+
+protected:
+  ClockModelSnapshot load_snapshot() const override;
+
+private:
+
+  mutable SharedClockModelReader m_reader;
+  mutable std::mutex m_attach_mutex;
+  mutable std::atomic<bool> m_attached;
+  mutable std::atomic<int64_t> m_next_attach_time; // steady_clock, ns
+
+  static constexpr std::chrono::seconds s_attach_retry_interval{ 1 };
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSHAREDMEMORY_HPP_
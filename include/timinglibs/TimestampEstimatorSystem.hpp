@@ -9,28 +9,104 @@
 #ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSYSTEM_HPP_
 #define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSYSTEM_HPP_
 
+#include "timinglibs/SeqLock.hpp"
 #include "timinglibs/TimestampEstimatorBase.hpp"
 #include "timinglibs/TimingIssues.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
 namespace dunedaq {
 namespace timinglibs {
 
 /**
  * @brief TimestampEstimatorSystem is an implementation of
  * TimestampEstimatorBase that uses the system clock to give the current timestamp
+ *
+ * The timestamp is the number of clock ticks since the epoch, computed
+ * exactly from the system time in ns: the clock frequency is kept as a
+ * reduced fraction of 1 GHz, so fractional-MHz frequencies such as
+ * 62.5 MHz are handled without rounding.
+ *
+ * Optionally, on x86_64 CPUs with an invariant TSC, the timestamp is
+ * extrapolated from the TSC instead, which avoids the clock read. The
+ * TSC rate is measured against the steady clock, which is never stepped,
+ * at construction and every s_tsc_recalibration_interval, when the
+ * estimate is also re-anchored to the system clock, so that it follows
+ * slews and steps of the system clock. The TSC path is only available
+ * with the real SystemClock.
  **/
 class TimestampEstimatorSystem : public TimestampEstimatorBase
 {
 public:
-  explicit TimestampEstimatorSystem(uint64_t clock_frequency_hz); // NOLINT(build/unsigned)
+  explicit TimestampEstimatorSystem(uint64_t clock_frequency_hz, bool use_tsc = false); // NOLINT(build/unsigned)
+
+  /**
+     Construct a TimestampEstimatorSystem which follows the system time of clock
+  */
+  TimestampEstimatorSystem(uint64_t clock_frequency_hz, std::shared_ptr<Clock> clock); // NOLINT(build/unsigned)
+
+  virtual ~TimestampEstimatorSystem();
 
   dfmessages::timestamp_t get_timestamp_estimate() const override;
 
+  /**
+     Whether the TSC fast path was requested and is available
+  */
+  bool is_using_tsc() const { return m_use_tsc; }
+
+  /**
+     The number of whole clock ticks in ns nanoseconds
+  */
+  dfmessages::timestamp_t ns_to_ticks(uint64_t ns) const // NOLINT(build/unsigned)
+  {
+    // Split the division so that the products can't overflow
+    return (ns / m_ns_per_tick_den) * m_ticks_per_ns_num +
+           (ns % m_ns_per_tick_den) * m_ticks_per_ns_num / m_ns_per_tick_den;
+  }
+
+  /**
+     The number of nanoseconds after which ticks clock ticks are complete
+  */
+  uint64_t ticks_to_ns(dfmessages::timestamp_t ticks) const // NOLINT(build/unsigned)
+  {
+    return (ticks / m_ticks_per_ns_num) * m_ns_per_tick_den +
+           ((ticks % m_ticks_per_ns_num) * m_ns_per_tick_den + m_ticks_per_ns_num - 1) / m_ticks_per_ns_num;
+  }
+
+protected:
+  bool get_host_time_for_timestamp(dfmessages::timestamp_t ts, int64_t& steady_time_ns) const override;
+
 private:
+  struct TscCalibration
+  {
+    uint64_t tsc;                     // NOLINT(build/unsigned)
+    int64_t system_time;              // ns, at tsc
+    int64_t steady_time;              // ns, at tsc
+    dfmessages::timestamp_t ticks;    // at tsc
+    uint64_t ticks_per_cycle;         // NOLINT(build/unsigned) 32.32 fixed point
+    uint64_t recalibration_cycles;    // NOLINT(build/unsigned)
+  };
+
+  void calibrate_tsc(const TscCalibration* previous) const;
+
   uint64_t m_clock_frequency_hz; // NOLINT(build/unsigned)
+  // m_clock_frequency_hz / 1e9 as a reduced fraction
+  uint64_t m_ticks_per_ns_num; // NOLINT(build/unsigned)
+  uint64_t m_ns_per_tick_den;  // NOLINT(build/unsigned)
+
+  bool m_use_tsc;
+  mutable SeqLock<TscCalibration> m_tsc_calibration;
+  mutable std::atomic_flag m_tsc_calibrating = ATOMIC_FLAG_INIT;
+
+  // How long the TSC is measured for the first calibration
+  static constexpr std::chrono::milliseconds s_tsc_calibration_time{ 20 };
+  static constexpr std::chrono::seconds s_tsc_recalibration_interval{ 1 };
 };
 
 } // namespace timinglibs
 } // namespace dunedaq
 
-#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSYSTEM_HPP_
\ No newline at end of file
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMESTAMPESTIMATORSYSTEM_HPP_
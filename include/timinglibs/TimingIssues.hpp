@@ -91,6 +91,18 @@ ERS_DECLARE_ISSUE_BASE(timinglibs,
                        ((std::string)hw_cmd_id),
                        ((std::string)device))
 
+ERS_DECLARE_ISSUE_BASE(timinglibs,
+                       UnknownHardwareCommandSequence,
+                       timinglibs::HardwareCommandIssue,
+                       " Hardware command sequence: " << sequence << " is not configured",
+                       ((std::string)hw_cmd_id),
+                       ((std::string)sequence))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  DuplicateHardwareCommandSequence,
+                  " Hardware command sequence: " << sequence << " is configured more than once",
+                  ((std::string)sequence))
+
 ERS_DECLARE_ISSUE_BASE(timinglibs,
                        TimingHardwareCommandRegistrationFailed,
                        appfwk::CommandRegistrationFailed,
@@ -98,6 +110,18 @@ ERS_DECLARE_ISSUE_BASE(timinglibs,
                        ((std::string)cmd)((std::string)name),
                        ERS_EMPTY)
 
+ERS_DECLARE_ISSUE(timinglibs,
+                  HardwareCommandResponsesNotConfigured,
+                  name << " can not wait for hw cmds, its hardware_command_responses_in queue is not connected",
+                  ((std::string)name))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  HardwareCommandNotSuccessful,
+                  name << ": hw cmd " << hw_cmd_id << " for " << device << " finished with status " << status << ": "
+                       << message,
+                  ((std::string)name)((std::string)hw_cmd_id)((std::string)device)((std::string)status)(
+                    (std::string)message))
+
 ERS_DECLARE_ISSUE(timinglibs, InvalidTimeSync, "An invalid TimeSync message was received", ERS_EMPTY)
 
 ERS_DECLARE_ISSUE(timinglibs, LateTimeSync, "The most recent TimeSync message is behind current system time by " << time_diff << " us.", ((uint64_t)time_diff))
@@ -107,6 +131,46 @@ ERS_DECLARE_ISSUE(timinglibs,
                   "Failed to get timestamp estimate (was interrupted)",
                   ERS_EMPTY)
 
+ERS_DECLARE_ISSUE(timinglibs,
+                  TimeSyncSourceOutlier,
+                  "TimeSyncs from source " << source << " are " << offset
+                                           << " ticks away from the other sources, ignoring them",
+                  ((int)source)((int64_t)offset))
+
+ERS_DECLARE_ISSUE_BASE(timinglibs,
+                       MissingEstimatorSharedMemoryName,
+                       appfwk::GeneralDAQModuleIssue,
+                       "read_estimate_from_shm is set, but no estimator_shm_name is given",
+                       ((std::string)name),
+                       ERS_EMPTY)
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  SharedMemoryIssue,
+                  "Shared memory segment " << shm_name << ": " << message,
+                  ((std::string)shm_name)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  EndpointTimestampReadFailed,
+                  "Failed to read the timestamp from the timing endpoint, " << failures << " time(s) in a row",
+                  ((uint64_t)failures))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  TimestampEstimatorClockFrequencyMismatch,
+                  "There is already a timestamp estimator for TimeSync queue "
+                    << queue_name << " at " << other_clock_frequency_hz << " Hz, not " << clock_frequency_hz
+                    << " Hz: the two will each see only part of the TimeSync messages",
+                  ((std::string)queue_name)((uint64_t)other_clock_frequency_hz)((uint64_t)clock_frequency_hz))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  StrandTaskFailed,
+                  "A task on strand " << strand << " failed",
+                  ((std::string)strand))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  FailedToWarmUpHwDevice,
+                  "Failed to connect to hw device " << device << " during configuration",
+                  ((std::string)device))
+
 ERS_DECLARE_ISSUE(timinglibs, HSIBufferIssue, "HSI buffer in state: " << buffer_state, ((std::string)buffer_state))
 
 ERS_DECLARE_ISSUE(timinglibs, HSIReadoutIssue, "Failed to read HSI events.", ERS_EMPTY)
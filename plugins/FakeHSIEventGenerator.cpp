@@ -31,9 +31,12 @@ FakeHSIEventGenerator::FakeHSIEventGenerator(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
   , m_thread(std::bind(&FakeHSIEventGenerator::generate_hsievents, this, std::placeholders::_1))
   , m_hsievent_sink(nullptr)
-  , m_time_sync_source(nullptr)
+  , m_time_sync_queue_name()
   , m_queue_timeout(100)
   , m_timestamp_estimator(nullptr)
+  , m_estimator_shm_name()
+  , m_read_estimate_from_shm(false)
+  , m_keep_estimator_warm(false)
   , m_random_generator()
   , m_uniform_distribution(0, UINT32_MAX)
   , m_clock_frequency(50e6)
@@ -42,12 +45,16 @@ FakeHSIEventGenerator::FakeHSIEventGenerator(const std::string& name)
   , m_hsi_device_id(0)
   , m_signal_emulation_mode(0)
   , m_mean_signal_multiplicity(0)
+  , m_saturate(false)
   , m_enabled_signals(0)
   , m_generated_counter(0)
   , m_sent_counter(0)
   , m_failed_to_send_counter(0)
   , m_last_generated_timestamp(0)
   , m_last_sent_timestamp(0)
+  , m_queue_full_stalls_counter(0)
+  , m_generation_start_time(0)
+  , m_generation_stop_time(0)
 {
   register_command("conf", &FakeHSIEventGenerator::do_configure);
   register_command("start", &FakeHSIEventGenerator::do_start);
@@ -60,15 +67,14 @@ FakeHSIEventGenerator::init(const nlohmann::json& init_data)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering init() method";
 
-  m_time_sync_source.reset(
-    new appfwk::DAQSource<dfmessages::TimeSync>(appfwk::queue_inst(init_data, "time_sync_source")));
+  m_time_sync_queue_name = appfwk::queue_inst(init_data, "time_sync_source");
   m_hsievent_sink.reset(new appfwk::DAQSink<dfmessages::HSIEvent>(appfwk::queue_inst(init_data, "hsievent_sink")));
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting init() method";
 }
 
 void
-FakeHSIEventGenerator::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+FakeHSIEventGenerator::get_info(opmonlib::InfoCollector& ci, int level)
 {
   // send counters internal to the module
   fakehsieventgeneratorinfo::Info module_info;
@@ -78,8 +84,34 @@ FakeHSIEventGenerator::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   module_info.failed_to_send_hsi_events_counter = m_failed_to_send_counter.load();
   module_info.last_generated_timestamp = m_last_generated_timestamp.load();
   module_info.last_sent_timestamp = m_last_sent_timestamp.load();
+  module_info.queue_full_stalls = m_queue_full_stalls_counter.load();
+
+  auto generation_start_time = m_generation_start_time.load();
+  if (generation_start_time != 0) {
+    // after a stop, the throughput of the run which has just ended
+    auto generation_end_time = m_generation_stop_time.load();
+    if (generation_end_time == 0) {
+      generation_end_time = std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+    double elapsed_seconds = (generation_end_time - generation_start_time) * 1e-9;
+    module_info.achieved_throughput = elapsed_seconds > 0 ? m_sent_counter.load() / elapsed_seconds : 0.;
+  }
+
+  module_info.push_latency_p50 = m_push_latency_histogram.percentile(0.5);
+  module_info.push_latency_p99 = m_push_latency_histogram.percentile(0.99);
+  module_info.push_latency_max = m_push_latency_histogram.max();
+  module_info.emission_jitter_p50 = m_emission_jitter_histogram.percentile(0.5);
+  module_info.emission_jitter_p99 = m_emission_jitter_histogram.percentile(0.99);
+  module_info.emission_jitter_max = m_emission_jitter_histogram.max();
+  module_info.emission_jitter_histogram = m_emission_jitter_histogram.octave_counts();
 
   ci.add(module_info);
+
+  // the estimator is replaced by do_start and do_stop, which may run concurrently with us
+  auto timestamp_estimator = std::atomic_load(&m_timestamp_estimator);
+  if (timestamp_estimator) {
+    timestamp_estimator->get_info(ci, level);
+  }
 }
 
 void
@@ -97,6 +129,13 @@ FakeHSIEventGenerator::do_configure(const nlohmann::json& obj)
   m_signal_emulation_mode = params.signal_emulation_mode;
   m_mean_signal_multiplicity = params.mean_signal_multiplicity;
   m_enabled_signals = params.enabled_signals;
+  m_saturate = params.saturate;
+  m_estimator_shm_name = params.estimator_shm_name;
+  m_read_estimate_from_shm = params.read_estimate_from_shm;
+  if (m_read_estimate_from_shm && m_estimator_shm_name.empty()) {
+    throw MissingEstimatorSharedMemoryName(ERS_HERE, get_name());
+  }
+  m_keep_estimator_warm = params.keep_estimator_warm;
 
   // configure the random distributions
   m_poisson_distribution = std::poisson_distribution<uint64_t>(m_mean_signal_multiplicity); // NOLINT(build/unsigned)
@@ -105,10 +144,30 @@ FakeHSIEventGenerator::do_configure(const nlohmann::json& obj)
 }
 
 void
-FakeHSIEventGenerator::do_start(const nlohmann::json& /*args*/)
+FakeHSIEventGenerator::do_start(const nlohmann::json& args)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_start() method";
-  m_timestamp_estimator.reset(new TimestampEstimator(m_time_sync_source, m_clock_frequency));
+  // ignore TimeSyncs left over from the previous run. a new estimator is given the run number before it reads its
+  // first TimeSync
+  auto run_number = args.value<dfmessages::run_number_t>("run", 0);
+  // a warm estimator from the previous run is re-used as it is
+  auto timestamp_estimator = std::atomic_load(&m_timestamp_estimator);
+  if (!timestamp_estimator) {
+    if (m_read_estimate_from_shm) {
+      timestamp_estimator = std::make_shared<TimestampEstimatorSharedMemory>(m_estimator_shm_name, m_clock_frequency);
+    } else {
+      auto estimator = TimestampEstimatorRegistry::get().get_estimator(m_time_sync_queue_name, m_clock_frequency, run_number);
+      if (!m_estimator_shm_name.empty()) {
+        estimator->publish_to_shared_memory(m_estimator_shm_name);
+      }
+      timestamp_estimator = estimator;
+    }
+    std::atomic_store(&m_timestamp_estimator, timestamp_estimator);
+  }
+  timestamp_estimator->set_run_number(run_number);
+  m_generation_start_time = 0;
+  m_generation_stop_time = 0;
+  m_waiting_allowed = true;
   m_thread.start_working_thread("fake-tsd-gen");
   TLOG() << get_name() << " successfully started";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
@@ -118,8 +177,18 @@ void
 FakeHSIEventGenerator::do_stop(const nlohmann::json& /*args*/)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_stop() method";
+  m_waiting_allowed = false;
+  if (auto timestamp_estimator = std::atomic_load(&m_timestamp_estimator)) {
+    timestamp_estimator->interrupt_waits();
+  }
   m_thread.stop_working_thread();
-  m_timestamp_estimator.reset(nullptr); // Calls TimestampEstimator dtor
+  if (m_generation_start_time.load() != 0) {
+    m_generation_stop_time = std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+  if (!m_keep_estimator_warm) {
+    // Calls TimestampEstimator dtor if we were the last user
+    std::atomic_store(&m_timestamp_estimator, std::shared_ptr<TimestampEstimatorBase>());
+  }
   TLOG() << get_name() << " successfully stopped";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
 }
@@ -128,6 +197,7 @@ void
 FakeHSIEventGenerator::do_scrap(const nlohmann::json& /*args*/)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
+  std::atomic_store(&m_timestamp_estimator, std::shared_ptr<TimestampEstimatorBase>());
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
 }
 
@@ -157,6 +227,18 @@ FakeHSIEventGenerator::generate_signal_map()
   return signal_map & m_enabled_signals;
 }
 
+void
+FakeHSIEventGenerator::push_hsievent(const dfmessages::HSIEvent& event, const std::chrono::milliseconds& timeout)
+{
+  auto push_start = std::chrono::steady_clock::now();
+  m_hsievent_sink->push(event, timeout);
+  auto push_latency = std::chrono::steady_clock::now() - push_start;
+  m_push_latency_histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(push_latency).count());
+
+  ++m_sent_counter;
+  m_last_sent_timestamp.store(event.timestamp);
+}
+
 void
 FakeHSIEventGenerator::generate_hsievents(std::atomic<bool>& running_flag)
 {
@@ -164,7 +246,7 @@ FakeHSIEventGenerator::generate_hsievents(std::atomic<bool>& running_flag)
 
   // Wait for there to be a valid timestsamp estimate before we start
   // TODO put in tome sort of timeout?
-  if (m_timestamp_estimator->wait_for_valid_timestamp(running_flag) == TimestampEstimatorBase::kInterrupted) {
+  if (m_timestamp_estimator->wait_for_valid_timestamp(m_waiting_allowed) == TimestampEstimatorBase::kInterrupted) {
     ers::error(FailedToGetTimestampEstimate(ERS_HERE));
     return;
   }
@@ -174,11 +256,28 @@ FakeHSIEventGenerator::generate_hsievents(std::atomic<bool>& running_flag)
   m_last_generated_timestamp = 0;
   m_last_sent_timestamp = 0;
   m_failed_to_send_counter = 0;
+  m_queue_full_stalls_counter = 0;
+  m_push_latency_histogram.reset();
+  m_emission_jitter_histogram.reset();
+
+  const std::chrono::nanoseconds event_period(m_event_period);
+  auto next_emission_time = std::chrono::steady_clock::now();
+  m_generation_start_time.store(next_emission_time.time_since_epoch().count());
 
   while (running_flag.load()) {
 
-    // sleep for the configured event period
-    std::this_thread::sleep_for(std::chrono::nanoseconds(m_event_period));
+    if (!m_saturate) {
+      // sleep until the next scheduled emission time, and record how late we actually woke up
+      next_emission_time += event_period;
+      std::this_thread::sleep_until(next_emission_time);
+      auto wake_time = std::chrono::steady_clock::now();
+      auto jitter = std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - next_emission_time);
+      m_emission_jitter_histogram.record(jitter.count() > 0 ? jitter.count() : 0);
+
+      // don't try to catch up with a burst of events if we have fallen more than a period behind
+      if (jitter > event_period)
+        next_emission_time = wake_time;
+    }
 
     // emulate some signals
     uint32_t signal_map = generate_signal_map(); // NOLINT(build/unsigned)
@@ -200,26 +299,36 @@ FakeHSIEventGenerator::generate_hsievents(std::atomic<bool>& running_flag)
 
       std::string thisQueueName = m_hsievent_sink->get_name();
       bool was_sent_successfully = false;
-      // do...while instead of while... so that we always try at least
-      // once to send everything we generate, even if running_flag is
-      // changed to false between the top of the main loop and here
-      do {
-        TLOG_DEBUG(2) << get_name() << ": Pushing the generated HSIEvent onto queue " << thisQueueName;
+
+      // in saturate mode, first try a push which does not wait: if it
+      // fails, the queue was full and the consumer is the bottleneck
+      if (m_saturate) {
         try {
-          m_hsievent_sink->push(event, m_queue_timeout);
+          push_hsievent(event, std::chrono::milliseconds(0));
           was_sent_successfully = true;
-
-          ++m_sent_counter;
-          m_last_sent_timestamp.store(ts);
-
         } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-          std::ostringstream oss_warn;
-          oss_warn << "push to output queue \"" << thisQueueName << "\"";
-          ers::warning(
-            dunedaq::appfwk::QueueTimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
-          ++m_failed_to_send_counter;
+          ++m_queue_full_stalls_counter;
         }
-      } while (!was_sent_successfully && running_flag.load());
+      }
+
+      // do...while instead of while... so that we always try at least
+      // once to send everything we generate, even if running_flag is
+      // changed to false between the top of the main loop and here
+      if (!was_sent_successfully) {
+        do {
+          TLOG_DEBUG(2) << get_name() << ": Pushing the generated HSIEvent onto queue " << thisQueueName;
+          try {
+            push_hsievent(event, m_queue_timeout);
+            was_sent_successfully = true;
+          } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+            std::ostringstream oss_warn;
+            oss_warn << "push to output queue \"" << thisQueueName << "\"";
+            ers::warning(
+              dunedaq::appfwk::QueueTimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
+            ++m_failed_to_send_counter;
+          }
+        } while (!was_sent_successfully && running_flag.load());
+      }
 
     } else {
       continue;
@@ -229,6 +338,11 @@ FakeHSIEventGenerator::generate_hsievents(std::atomic<bool>& running_flag)
   std::ostringstream oss_summ;
   oss_summ << ": Exiting the generate_hsievents() method, generated " << m_generated_counter
            << " HSIEvent messages and successfully sent " << m_sent_counter << " copies. ";
+  if (m_saturate) {
+    oss_summ << "Saturate mode: " << m_queue_full_stalls_counter << " queue-full stalls, push latency p50/p99/max "
+             << m_push_latency_histogram.percentile(0.5) << "/" << m_push_latency_histogram.percentile(0.99) << "/"
+             << m_push_latency_histogram.max() << " ns. ";
+  }
   ers::info(dunedaq::timinglibs::ProgressUpdate(ERS_HERE, get_name(), oss_summ.str()));
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
 }
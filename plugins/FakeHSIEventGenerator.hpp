@@ -15,7 +15,10 @@
 
 #include "timinglibs/TimingIssues.hpp"
 
+#include "timinglibs/LogHistogram.hpp"
 #include "timinglibs/TimestampEstimator.hpp"
+#include "timinglibs/TimestampEstimatorRegistry.hpp"
+#include "timinglibs/TimestampEstimatorSharedMemory.hpp"
 
 #include "dfmessages/HSIEvent.hpp"
 
@@ -67,15 +70,21 @@ private:
   // Threading
   dunedaq::appfwk::ThreadHelper m_thread;
   void generate_hsievents(std::atomic<bool>&);
+  // dropped by do_stop before it wakes the estimator's waits, so that generate_hsievents stops waiting at once
+  std::atomic<bool> m_waiting_allowed{ false };
 
   // Configuration
   using sink_t = dunedaq::appfwk::DAQSink<dfmessages::HSIEvent>;
   std::unique_ptr<sink_t> m_hsievent_sink;
-  std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>> m_time_sync_source;
+  std::string m_time_sync_queue_name;
   std::chrono::milliseconds m_queue_timeout;
 
-  // Interface to consume TimeSync messages
-  std::unique_ptr<TimestampEstimator> m_timestamp_estimator;
+  // Interface to consume TimeSync messages, shared with the other modules reading the same queue,
+  // or to read the estimate published by another process
+  std::shared_ptr<TimestampEstimatorBase> m_timestamp_estimator;
+  std::string m_estimator_shm_name;
+  bool m_read_estimate_from_shm;
+  bool m_keep_estimator_warm;
 
   // Random Generatior
   std::default_random_engine m_random_generator;
@@ -84,6 +93,8 @@ private:
 
   uint32_t generate_signal_map(); // NOLINT(build/unsigned)
 
+  void push_hsievent(const dfmessages::HSIEvent& event, const std::chrono::milliseconds& timeout);
+
   uint64_t m_clock_frequency; // NOLINT(build/unsigned)
   uint64_t m_event_period;    // NOLINT(build/unsigned)
   int64_t m_timestamp_offset;
@@ -91,6 +102,7 @@ private:
   uint32_t m_hsi_device_id;            // NOLINT(build/unsigned)
   uint m_signal_emulation_mode;        // NOLINT(build/unsigned)
   uint64_t m_mean_signal_multiplicity; // NOLINT(build/unsigned)
+  bool m_saturate;
 
   uint32_t m_enabled_signals;                       // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_generated_counter;        // NOLINT(build/unsigned)
@@ -98,6 +110,12 @@ private:
   std::atomic<uint64_t> m_failed_to_send_counter;   // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_last_generated_timestamp; // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_last_sent_timestamp;      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_queue_full_stalls_counter; // NOLINT(build/unsigned)
+  std::atomic<int64_t> m_generation_start_time;      // steady_clock, ns
+  std::atomic<int64_t> m_generation_stop_time;       // steady_clock, ns. 0 while generating
+
+  LogHistogram m_push_latency_histogram;    // ns
+  LogHistogram m_emission_jitter_histogram; // ns
 };
 } // namespace timinglibs
 } // namespace dunedaq
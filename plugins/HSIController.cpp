@@ -60,7 +60,7 @@ HSIController::do_configure(const nlohmann::json& obj)
 }
 
 void
-HSIController::construct_hsi_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id)
+HSIController::construct_hsi_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id)
 {
   hw_cmd.id = cmd_id;
   hw_cmd.device = m_cfg.device;
@@ -70,7 +70,7 @@ void
 HSIController::do_hsi_io_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "io_reset");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::io_reset);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -81,7 +81,7 @@ void
 HSIController::do_hsi_endpoint_enable(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "endpoint_enable");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_enable);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -92,7 +92,7 @@ void
 HSIController::do_hsi_endpoint_disable(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "endpoint_disable");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_disable);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(2).atomic);
 }
@@ -101,7 +101,7 @@ void
 HSIController::do_hsi_endpoint_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "endpoint_reset");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_reset);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -112,7 +112,7 @@ void
 HSIController::do_hsi_reset(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "hsi_reset");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::hsi_reset);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(4).atomic);
 }
@@ -121,7 +121,7 @@ void
 HSIController::do_hsi_configure(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "hsi_configure");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::hsi_configure);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -132,7 +132,7 @@ void
 HSIController::do_hsi_start(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "hsi_start");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::hsi_start);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(6).atomic);
 }
@@ -141,7 +141,7 @@ void
 HSIController::do_hsi_stop(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "hsi_stop");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::hsi_stop);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(7).atomic);
 }
@@ -150,7 +150,7 @@ void
 HSIController::do_hsi_print_status(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_hsi_hw_cmd(hw_cmd, "print_status");
+  construct_hsi_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::print_status);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(8).atomic);
 }
@@ -60,7 +60,7 @@ private:
   // Commands
   void do_configure(const nlohmann::json& obj) override;
 
-  void construct_hsi_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id);
+  void construct_hsi_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id);
 
   // timinglibs hsi commands
   void do_hsi_io_reset(const nlohmann::json& data);
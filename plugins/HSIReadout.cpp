@@ -153,7 +153,7 @@ HSIReadout::read_hsievents(std::atomic<bool>& running_flag)
     try {
       uint16_t n_words_in_buffer; // NOLINT(build/unsigned)
 
-      auto hsi_node = m_hsi_device->getNode<timing::HSINode>("endpoint0");
+      const auto& hsi_node = m_hsi_device->getNode<timing::HSINode>("endpoint0");
       auto hsi_words = hsi_node.read_data_buffer(n_words_in_buffer, false, true);
 
       update_buffer_counts(n_words_in_buffer);
@@ -57,7 +57,7 @@ TimingEndpointController::do_configure(const nlohmann::json& obj)
 }
 
 void
-TimingEndpointController::construct_endpoint_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id)
+TimingEndpointController::construct_endpoint_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id)
 {
   hw_cmd.id = cmd_id;
   hw_cmd.device = m_cfg.device;
@@ -67,7 +67,7 @@ void
 TimingEndpointController::do_endpoint_io_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "io_reset");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::io_reset);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -78,7 +78,7 @@ void
 TimingEndpointController::do_endpoint_enable(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "endpoint_enable");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_enable);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -89,7 +89,7 @@ void
 TimingEndpointController::do_endpoint_disable(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "endpoint_disable");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_disable);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(2).atomic);
 }
@@ -98,7 +98,7 @@ void
 TimingEndpointController::do_endpoint_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "endpoint_reset");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_reset);
   hw_cmd.payload = data;
 
   send_hw_cmd(hw_cmd);
@@ -109,7 +109,7 @@ void
 TimingEndpointController::do_endpoint_print_timestamp(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "endpoint_print_timestamp");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::endpoint_print_timestamp);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(4).atomic);
 }
@@ -118,7 +118,7 @@ void
 TimingEndpointController::do_endpoint_print_status(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_endpoint_hw_cmd(hw_cmd, "print_status");
+  construct_endpoint_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::print_status);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(5).atomic);
 }
@@ -63,7 +63,7 @@ private:
   // Commands
   void do_configure(const nlohmann::json& obj) override;
 
-  void construct_endpoint_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id);
+  void construct_endpoint_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id);
 
   // timinglibs endpoint commands
   void do_endpoint_io_reset(const nlohmann::json& data);
@@ -50,7 +50,7 @@ TimingFanoutController::do_configure(const nlohmann::json& obj)
 }
 
 void
-TimingFanoutController::construct_fanout_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id)
+TimingFanoutController::construct_fanout_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id)
 {
   hw_cmd.id = cmd_id;
   hw_cmd.device = m_cfg.device;
@@ -60,7 +60,7 @@ void
 TimingFanoutController::do_fanout_io_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_fanout_hw_cmd(hw_cmd, "io_reset");
+  construct_fanout_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::io_reset);
   hw_cmd.payload = data;
   hw_cmd.payload["fanout_mode"] = 0; // fanout mode for fanout design
 
@@ -72,7 +72,7 @@ void
 TimingFanoutController::do_fanout_print_status(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_fanout_hw_cmd(hw_cmd, "print_status");
+  construct_fanout_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::print_status);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(1).atomic);
 }
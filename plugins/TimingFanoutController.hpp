@@ -62,7 +62,7 @@ private:
   // Commands
   void do_configure(const nlohmann::json& obj) override;
 
-  void construct_fanout_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id);
+  void construct_fanout_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id);
 
   // timing master commands
   void do_fanout_io_reset(const nlohmann::json& data);
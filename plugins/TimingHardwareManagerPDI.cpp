@@ -93,51 +93,68 @@ template<class DSGN>
 void
 TimingHardwareManagerPDI::register_common_hw_commands_for_design()
 {
-  register_timing_hw_command("io_reset", typeid(DSGN).name(), &TimingHardwareManagerPDI::io_reset<DSGN>);
-  register_timing_hw_command("print_status", typeid(DSGN).name(), &TimingHardwareManagerPDI::print_status<DSGN>);
+  using timingcmd::TimingHwCmdId;
+  register_timing_hw_command(TimingHwCmdId::io_reset, typeid(DSGN).name(), &TimingHardwareManagerPDI::io_reset<DSGN>);
+  register_timing_hw_command(
+    TimingHwCmdId::print_status, typeid(DSGN).name(), &TimingHardwareManagerPDI::print_status<DSGN>);
 }
 
 template<class DSGN>
 void
 TimingHardwareManagerPDI::register_master_hw_commands_for_design()
 {
-  register_timing_hw_command("set_timestamp", typeid(DSGN).name(), &TimingHardwareManagerPDI::set_timestamp<DSGN>);
+  using timingcmd::TimingHwCmdId;
   register_timing_hw_command(
-    "partition_configure", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_configure<DSGN>);
+    TimingHwCmdId::set_timestamp, typeid(DSGN).name(), &TimingHardwareManagerPDI::set_timestamp<DSGN>);
   register_timing_hw_command(
-    "partition_enable", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_enable<DSGN>);
+    TimingHwCmdId::partition_configure, typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_configure<DSGN>);
   register_timing_hw_command(
-    "partition_disable", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_disable<DSGN>);
-  register_timing_hw_command("partition_start", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_start<DSGN>);
-  register_timing_hw_command("partition_stop", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_stop<DSGN>);
+    TimingHwCmdId::partition_enable, typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_enable<DSGN>);
   register_timing_hw_command(
-    "partition_enable_triggers", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_enable_triggers<DSGN>);
+    TimingHwCmdId::partition_disable, typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_disable<DSGN>);
   register_timing_hw_command(
-    "partition_disable_triggers", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_disable_triggers<DSGN>);
+    TimingHwCmdId::partition_start, typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_start<DSGN>);
   register_timing_hw_command(
-    "partition_print_status", typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_print_status<DSGN>);
+    TimingHwCmdId::partition_stop, typeid(DSGN).name(), &TimingHardwareManagerPDI::partition_stop<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::partition_enable_triggers,
+                             typeid(DSGN).name(),
+                             &TimingHardwareManagerPDI::partition_enable_triggers<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::partition_disable_triggers,
+                             typeid(DSGN).name(),
+                             &TimingHardwareManagerPDI::partition_disable_triggers<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::partition_print_status,
+                             typeid(DSGN).name(),
+                             &TimingHardwareManagerPDI::partition_print_status<DSGN>);
 }
 
 template<class DSGN>
 void
 TimingHardwareManagerPDI::register_endpoint_hw_commands_for_design()
 {
-  register_timing_hw_command("endpoint_enable", typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_enable<DSGN>);
+  using timingcmd::TimingHwCmdId;
+  register_timing_hw_command(
+    TimingHwCmdId::endpoint_enable, typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_enable<DSGN>);
   register_timing_hw_command(
-    "endpoint_disable", typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_disable<DSGN>);
-  register_timing_hw_command("endpoint_reset", typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_reset<DSGN>);
+    TimingHwCmdId::endpoint_disable, typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_disable<DSGN>);
+  register_timing_hw_command(
+    TimingHwCmdId::endpoint_reset, typeid(DSGN).name(), &TimingHardwareManagerPDI::endpoint_reset<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::endpoint_print_timestamp,
+                             typeid(DSGN).name(),
+                             &TimingHardwareManagerPDI::endpoint_print_timestamp<DSGN>);
 }
 
 template<class DSGN>
 void
 TimingHardwareManagerPDI::register_hsi_hw_commands_for_design()
 {
-  register_timing_hw_command("hsi_reset", typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_reset<DSGN>);
-  register_timing_hw_command("hsi_configure", typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_configure<DSGN>);
-  register_timing_hw_command("hsi_start", typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_start<DSGN>);
-  register_timing_hw_command("hsi_stop", typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_stop<DSGN>);
+  using timingcmd::TimingHwCmdId;
+  register_timing_hw_command(TimingHwCmdId::hsi_reset, typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_reset<DSGN>);
+  register_timing_hw_command(
+    TimingHwCmdId::hsi_configure, typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_configure<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::hsi_start, typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_start<DSGN>);
+  register_timing_hw_command(TimingHwCmdId::hsi_stop, typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_stop<DSGN>);
   register_timing_hw_command(
-    "hsi_print_status", typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_print_status<DSGN>);
+    TimingHwCmdId::hsi_print_status, typeid(DSGN).name(), &TimingHardwareManagerPDI::hsi_print_status<DSGN>);
 }
 
 void
@@ -167,6 +184,7 @@ TimingHardwareManagerPDI::do_configure(const nlohmann::json& obj)
     throw InvalidUHALLogLevel(ERS_HERE, m_cfg.uhal_log_level);
   }
 
+  clear_hw_devices();
   try {
     m_connection_manager = std::make_unique<uhal::ConnectionManager>("file://" + m_connections_file);
   } catch (const uhal::exception::FileNotFound& excpt) {
@@ -175,6 +193,15 @@ TimingHardwareManagerPDI::do_configure(const nlohmann::json& obj)
     throw UHALConnectionsFileIssue(ERS_HERE, message.str(), excpt);
   }
 
+  set_hw_cmd_sequences(m_cfg.hw_cmd_sequences);
+
+  // connect to the configured devices now, rather than when they are first used
+  std::vector<std::string> device_names = m_cfg.monitored_device_names_fanout;
+  device_names.push_back(m_cfg.monitored_device_name_master);
+  device_names.push_back(m_cfg.monitored_device_name_endpoint);
+  device_names.push_back(m_cfg.monitored_device_name_hsi);
+  warm_up_hw_devices(device_names);
+
   // monitoring
   // only register monitor threads if we have been given the name of the device to monitor
   if (m_cfg.monitored_device_name_master.compare("")) {
@@ -237,6 +264,10 @@ TimingHardwareManagerPDI::do_configure(const nlohmann::json& obj)
       m_cfg.gather_interval_debug, m_cfg.monitored_device_name_endpoint, 2);
   }
   start_hw_mon_gathering();
+  // one more worker is kept free for stopping triggers, however busy the others are
+  m_hw_cmd_strands =
+    std::make_unique<StrandPool>(m_cfg.hw_cmd_worker_threads, "tde-hw-cmd", 1, s_trigger_stop_hw_cmd_priority);
+  m_hw_cmd_strands_stopping = false;
   thread_.start_working_thread();
 }
 
@@ -250,6 +281,30 @@ TimingHardwareManagerPDI::get_info(opmonlib::InfoCollector& ci, int level)
   module_info.accepted_hw_commands_counter = m_accepted_hw_commands_counter.load();
   module_info.rejected_hw_commands_counter = m_rejected_hw_commands_counter.load();
   module_info.failed_hw_commands_counter = m_failed_hw_commands_counter.load();
+  module_info.skipped_hw_commands_counter = m_skipped_hw_commands_counter.load();
+  module_info.dropped_hw_cmd_responses_counter = m_dropped_hw_cmd_responses_counter.load();
+
+  {
+    std::lock_guard<std::mutex> lk(m_hw_cmd_latencies_mutex);
+    for (auto& [cmd_and_device, latencies] : m_hw_cmd_latencies) {
+      if (latencies.execution.count() == 0) {
+        continue;
+      }
+      timinghardwaremanagerpdiinfo::HwCmdLatencies cmd_latencies;
+      cmd_latencies.hw_cmd = get_hw_cmd_name(cmd_and_device.first);
+      cmd_latencies.device = cmd_and_device.second;
+      cmd_latencies.executed = latencies.execution.count();
+      cmd_latencies.queue_wait_p50 = latencies.queue_wait.percentile(0.5);
+      cmd_latencies.queue_wait_p99 = latencies.queue_wait.percentile(0.99);
+      cmd_latencies.queue_wait_max = latencies.queue_wait.max();
+      cmd_latencies.queue_wait_histogram = latencies.queue_wait.octave_counts();
+      cmd_latencies.execution_p50 = latencies.execution.percentile(0.5);
+      cmd_latencies.execution_p99 = latencies.execution.percentile(0.99);
+      cmd_latencies.execution_max = latencies.execution.max();
+      cmd_latencies.execution_histogram = latencies.execution.octave_counts();
+      module_info.hw_cmd_latencies.push_back(cmd_latencies);
+    }
+  }
 
   ci.add(module_info);
 
@@ -15,6 +15,8 @@
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 
+#include "timinglibs/TimingIssues.hpp"
+
 #include "appfwk/DAQModuleHelper.hpp"
 #include "appfwk/cmd/Nljs.hpp"
 
@@ -30,7 +32,7 @@ namespace dunedaq {
 namespace timinglibs {
 
 TimingMasterController::TimingMasterController(const std::string& name)
-  : dunedaq::timinglibs::TimingController(name, 3) // 2nd arg: how many hw commands can this module send?
+  : dunedaq::timinglibs::TimingController(name, 4) // 2nd arg: how many hw commands can this module send?
 {
   register_command("conf", &TimingMasterController::do_configure);
   register_command("start", &TimingMasterController::do_start);
@@ -40,6 +42,7 @@ TimingMasterController::TimingMasterController(const std::string& name)
   register_command("master_io_reset", &TimingMasterController::do_master_io_reset);
   register_command("master_set_timestamp", &TimingMasterController::do_master_set_timestamp);
   register_command("master_print_status", &TimingMasterController::do_master_print_status);
+  register_command("master_run_sequence", &TimingMasterController::do_master_run_sequence);
 }
 
 void
@@ -51,7 +54,7 @@ TimingMasterController::do_configure(const nlohmann::json& obj)
 }
 
 void
-TimingMasterController::construct_master_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id)
+TimingMasterController::construct_master_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id)
 {
   hw_cmd.id = cmd_id;
   hw_cmd.device = m_cfg.device;
@@ -61,7 +64,7 @@ void
 TimingMasterController::do_master_io_reset(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_master_hw_cmd(hw_cmd, "io_reset");
+  construct_master_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::io_reset);
   hw_cmd.payload = data;
   hw_cmd.payload["fanout_mode"] = 1; // put hw in standalone if fanout design
 
@@ -73,7 +76,7 @@ void
 TimingMasterController::do_master_set_timestamp(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_master_hw_cmd(hw_cmd, "set_timestamp");
+  construct_master_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::set_timestamp);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(1).atomic);
 }
@@ -82,11 +85,44 @@ void
 TimingMasterController::do_master_print_status(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_master_hw_cmd(hw_cmd, "print_status");
+  construct_master_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::print_status);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(2).atomic);
 }
 
+void
+TimingMasterController::do_master_run_sequence(const nlohmann::json& data)
+{
+  timingcmd::TimingHwCmd hw_cmd;
+  construct_master_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::sequence);
+  hw_cmd.payload = data;
+
+  if (!m_hw_cmd_response_in_queue) {
+    send_hw_cmd(hw_cmd);
+    ++(m_sent_hw_command_counters.at(3).atomic);
+    return;
+  }
+
+  // a sequence brings the master up, so say whether it worked rather than leaving it to the manager's log
+  auto response = send_hw_cmd_and_wait(hw_cmd, std::chrono::milliseconds(m_cfg.sequence_timeout));
+  ++(m_sent_hw_command_counters.at(3).atomic);
+  if (response.status != timingcmd::TimingHwCmdStatus::ok) {
+    nlohmann::json hw_cmd_id_json;
+    nlohmann::json status_json;
+    timingcmd::to_json(hw_cmd_id_json, hw_cmd.id);
+    timingcmd::to_json(status_json, response.status);
+    ers::error(HardwareCommandNotSuccessful(ERS_HERE,
+                                            get_name(),
+                                            hw_cmd_id_json.get<std::string>(),
+                                            hw_cmd.device,
+                                            status_json.get<std::string>(),
+                                            response.message));
+    return;
+  }
+  TLOG() << get_name() << ": hw cmd sequence " << data.value("name", "") << " completed in "
+         << response.execution_time_us << " us";
+}
+
 void
 TimingMasterController::get_info(opmonlib::InfoCollector& ci, int /*level*/)
 {
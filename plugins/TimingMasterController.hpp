@@ -62,12 +62,14 @@ private:
   // Commands
   void do_configure(const nlohmann::json& obj) override;
 
-  void construct_master_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id);
+  void construct_master_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id);
 
   // timing master commands
   void do_master_io_reset(const nlohmann::json& data);
   void do_master_set_timestamp(const nlohmann::json&);
   void do_master_print_status(const nlohmann::json&);
+  // run a hw cmd sequence from the hw manager configuration
+  void do_master_run_sequence(const nlohmann::json&);
 
   // Configuration
   timingmastercontroller::ConfParams m_cfg;
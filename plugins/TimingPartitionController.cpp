@@ -54,11 +54,12 @@ TimingPartitionController::do_configure(const nlohmann::json& obj)
 {
   timingpartitioncontroller::from_json(obj, m_cfg);
 
-  TLOG() << get_name() << " conf: managed partition, device: " << m_cfg.device << ", part id: " << m_cfg.partition_id;
+  TLOG() << get_name() << " conf: managed partition, device: " << m_cfg.device << ", part id: " << m_cfg.partition_id
+         << ", enable on configure: " << m_cfg.enable_on_configure;
 }
 
 void
-TimingPartitionController::construct_partition_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id)
+TimingPartitionController::construct_partition_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id)
 {
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   cmd_payload.partition_id = m_cfg.partition_id;
@@ -71,7 +72,7 @@ void
 TimingPartitionController::do_partition_configure(const nlohmann::json& data)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  hw_cmd.id = "partition_configure";
+  hw_cmd.id = timingcmd::TimingHwCmdId::partition_configure;
   hw_cmd.device = m_cfg.device;
 
   // make our configure payload with partition id of this controller
@@ -81,15 +82,25 @@ TimingPartitionController::do_partition_configure(const nlohmann::json& data)
 
   timingcmd::to_json(hw_cmd.payload, cmd_payload);
 
-  send_hw_cmd(hw_cmd);
+  if (!m_cfg.enable_on_configure) {
+    send_hw_cmd(hw_cmd);
+    ++(m_sent_hw_command_counters.at(0).atomic);
+    return;
+  }
+
+  // configure resets the partition, so enable it in the same batch: no other command for the device gets in between
+  timingcmd::TimingHwCmd enable_hw_cmd;
+  construct_partition_hw_cmd(enable_hw_cmd, timingcmd::TimingHwCmdId::partition_enable);
+  send_hw_cmd_batch({ hw_cmd, enable_hw_cmd });
   ++(m_sent_hw_command_counters.at(0).atomic);
+  ++(m_sent_hw_command_counters.at(1).atomic);
 }
 
 void
 TimingPartitionController::do_partition_enable(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_enable");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_enable);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(1).atomic);
 }
@@ -98,7 +109,7 @@ void
 TimingPartitionController::do_partition_disable(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_disable");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_disable);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(2).atomic);
 }
@@ -107,7 +118,7 @@ void
 TimingPartitionController::do_partition_start(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_start");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_start);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(3).atomic);
 }
@@ -116,7 +127,7 @@ void
 TimingPartitionController::do_partition_stop(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_stop");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_stop);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(4).atomic);
 }
@@ -125,7 +136,7 @@ void
 TimingPartitionController::do_partition_enable_triggers(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_enable_triggers");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_enable_triggers);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(5).atomic);
 }
@@ -134,7 +145,7 @@ void
 TimingPartitionController::do_partition_disable_triggers(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_disable_triggers");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_disable_triggers);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(6).atomic);
 }
@@ -143,7 +154,7 @@ void
 TimingPartitionController::do_partition_print_status(const nlohmann::json&)
 {
   timingcmd::TimingHwCmd hw_cmd;
-  construct_partition_hw_cmd(hw_cmd, "partition_print_status");
+  construct_partition_hw_cmd(hw_cmd, timingcmd::TimingHwCmdId::partition_print_status);
   send_hw_cmd(hw_cmd);
   ++(m_sent_hw_command_counters.at(7).atomic);
 }
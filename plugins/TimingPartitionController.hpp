@@ -66,7 +66,7 @@ private:
   // Commands
   void do_configure(const nlohmann::json& obj) override;
 
-  void construct_partition_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, const std::string& cmd_id);
+  void construct_partition_hw_cmd(timingcmd::TimingHwCmd& hw_cmd, timingcmd::TimingHwCmdId cmd_id);
 
   // timing partition commands
   void do_partition_configure(const nlohmann::json& data);
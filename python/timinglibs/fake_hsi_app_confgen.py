@@ -42,6 +42,7 @@ def generate(
         MEAN_SIGNAL_MULTIPLICITY: int = 0,
         SIGNAL_EMULATION_MODE: int = 0,
         ENABLED_SIGNALS: int = 0b00000001,
+        SATURATE: bool = False,
     ):
 
     network_endpoints={
@@ -96,6 +97,7 @@ def generate(
                         mean_signal_multiplicity=MEAN_SIGNAL_MULTIPLICITY,
                         signal_emulation_mode=SIGNAL_EMULATION_MODE,
                         enabled_signals=ENABLED_SIGNALS,
+                        saturate=SATURATE,
                         )),
             ]
 
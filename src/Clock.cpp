@@ -0,0 +1,126 @@
+/**
+ * @file Clock.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/Clock.hpp"
+
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace dunedaq {
+namespace timinglibs {
+
+std::shared_ptr<SystemClock>
+SystemClock::get()
+{
+  static std::shared_ptr<SystemClock> s_instance = std::make_shared<SystemClock>();
+  return s_instance;
+}
+
+int64_t
+SystemClock::system_time_ns() const
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+int64_t
+SystemClock::steady_time_ns() const
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void
+SystemClock::sleep_for(std::chrono::nanoseconds duration) const
+{
+  std::this_thread::sleep_for(duration);
+}
+
+void
+SystemClock::wait_until(std::condition_variable& cv,
+                        std::unique_lock<std::mutex>& lk,
+                        int64_t steady_deadline_ns) const
+{
+  cv.wait_until(lk, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(steady_deadline_ns)));
+}
+
+VirtualClock::VirtualClock(int64_t system_time_ns, int64_t steady_time_ns)
+  : m_system_time_ns(system_time_ns)
+  , m_steady_time_ns(steady_time_ns)
+{}
+
+void
+VirtualClock::sleep_for(std::chrono::nanoseconds duration) const
+{
+  const int64_t deadline = steady_time_ns() + duration.count();
+  std::unique_lock<std::mutex> lk(m_sleep_mutex);
+  m_sleep_cv.wait(lk, [&]() { return steady_time_ns() >= deadline; });
+}
+
+void
+VirtualClock::wait_until(std::condition_variable& cv,
+                         std::unique_lock<std::mutex>& lk,
+                         int64_t steady_deadline_ns) const
+{
+  // The time can only reach the deadline in advance(), whose listener
+  // notifies cv. Since the caller holds lk, the time can't change
+  // unnoticed between this check and the wait
+  if (steady_time_ns() < steady_deadline_ns) {
+    cv.wait(lk);
+  }
+}
+
+size_t
+VirtualClock::add_listener(Listener listener)
+{
+  std::lock_guard<std::mutex> lk(m_listener_mutex);
+  m_listeners.emplace(m_next_listener_id, std::move(listener));
+  return m_next_listener_id++;
+}
+
+void
+VirtualClock::remove_listener(size_t id)
+{
+  std::lock_guard<std::mutex> lk(m_listener_mutex);
+  m_listeners.erase(id);
+}
+
+void
+VirtualClock::advance(std::chrono::nanoseconds duration)
+{
+  m_system_time_ns.fetch_add(duration.count());
+  m_steady_time_ns.fetch_add(duration.count());
+  notify();
+}
+
+void
+VirtualClock::step_system_time(std::chrono::nanoseconds step)
+{
+  m_system_time_ns.fetch_add(step.count());
+  notify();
+}
+
+void
+VirtualClock::notify()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_sleep_mutex);
+    m_sleep_cv.notify_all();
+  }
+  // Holding m_listener_mutex keeps the listeners alive while they are
+  // called. Listeners take their own locks, which are never held while
+  // adding or removing a listener, so this can't deadlock
+  std::lock_guard<std::mutex> lk(m_listener_mutex);
+  for (auto& [id, listener] : m_listeners) {
+    listener();
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -0,0 +1,262 @@
+/**
+ * @file ClockModel.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/ClockModel.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#define TRACE_NAME "ClockModel" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+dfmessages::timestamp_t
+ClockModelSnapshot::predict(int64_t host_time) const
+{
+  double ticks = 0.;
+  if (host_time <= slew_end_host_time) {
+    ticks = (host_time - anchor_host_time) * slew_rate_hz * 1e-9;
+  } else {
+    ticks = (slew_end_host_time - anchor_host_time) * slew_rate_hz * 1e-9 +
+            (host_time - slew_end_host_time) * rate_hz * 1e-9;
+  }
+  auto delta = std::llround(ticks);
+  if (delta < 0 && static_cast<dfmessages::timestamp_t>(-delta) > anchor_daq_time) {
+    return 0;
+  }
+  return anchor_daq_time + delta;
+}
+
+dfmessages::timestamp_t
+ClockModelSnapshot::error_bound(int64_t host_time) const
+{
+  double remaining_slew = 0.;
+  if (slew_end_host_time > anchor_host_time) {
+    double fraction = static_cast<double>(host_time - anchor_host_time) / (slew_end_host_time - anchor_host_time);
+    remaining_slew = slew_correction * (1. - std::clamp(fraction, 0., 1.));
+  }
+  double elapsed = std::abs(host_time - anchor_host_time) * 1e-9;
+  return std::llround(error_at_anchor + std::abs(remaining_slew) + elapsed * rate_error_hz);
+}
+
+int64_t
+ClockModelSnapshot::host_time_for(dfmessages::timestamp_t daq_time) const
+{
+  double ticks = static_cast<double>(static_cast<int64_t>(daq_time - anchor_daq_time));
+  double slew_ticks = (slew_end_host_time - anchor_host_time) * slew_rate_hz * 1e-9;
+  double host_time = 0.;
+  if (ticks <= slew_ticks && slew_rate_hz > 0.) {
+    host_time = anchor_host_time + ticks / slew_rate_hz * 1e9;
+  } else {
+    host_time = slew_end_host_time + (ticks - slew_ticks) / rate_hz * 1e9;
+  }
+  return static_cast<int64_t>(std::clamp(host_time, -9.2e18, 9.2e18));
+}
+
+ClockModel::ClockModel(uint64_t nominal_clock_frequency_hz, size_t window_size) // NOLINT(build/unsigned)
+  : m_nominal_clock_frequency_hz(nominal_clock_frequency_hz)
+  , m_window_size(std::max<size_t>(window_size, 1))
+{}
+
+void
+ClockModel::reset()
+{
+  m_points.clear();
+  m_snapshot = ClockModelSnapshot();
+}
+
+int64_t
+ClockModel::add_point(dfmessages::timestamp_t daq_time, int64_t host_time, int64_t now)
+{
+  int64_t residual = 0;
+  if (m_snapshot.valid) {
+    residual = static_cast<int64_t>(daq_time - m_snapshot.predict(host_time));
+  }
+
+  m_points.push_back(Point{ daq_time, host_time });
+  while (m_points.size() > m_window_size) {
+    m_points.pop_front();
+  }
+
+  fit(now);
+  return residual;
+}
+
+void
+ClockModel::fit(int64_t now)
+{
+  if (m_points.empty()) {
+    m_snapshot = ClockModelSnapshot();
+    return;
+  }
+
+  // Work relative to the newest point, so that the numbers stay small
+  // enough for double precision
+  const Point& reference = m_points.back();
+  const size_t n_points = m_points.size();
+  std::vector<double> x(n_points), y(n_points);
+  double x_min = 0., x_max = 0.;
+  for (size_t i = 0; i < n_points; ++i) {
+    x[i] = (m_points[i].host_time - reference.host_time) * 1e-9;
+    y[i] = static_cast<double>(static_cast<int64_t>(m_points[i].daq_time - reference.daq_time));
+    x_min = std::min(x_min, x[i]);
+    x_max = std::max(x_max, x[i]);
+  }
+  const bool fit_rate = n_points >= 3 && (x_max - x_min) >= s_min_rate_fit_span;
+
+  std::vector<bool> use(n_points, true);
+  double offset = 0., rate = m_nominal_clock_frequency_hz, x_mean = 0., sxx = 0., sigma = 0.;
+  size_t n_used = 0;
+  bool rate_fitted = false;
+
+  auto least_squares = [&]() {
+    double y_mean = 0.;
+    n_used = 0;
+    x_mean = 0.;
+    for (size_t i = 0; i < n_points; ++i) {
+      if (use[i]) {
+        x_mean += x[i];
+        y_mean += y[i];
+        ++n_used;
+      }
+    }
+    x_mean /= n_used;
+    y_mean /= n_used;
+
+    sxx = 0.;
+    double sxy = 0.;
+    for (size_t i = 0; i < n_points; ++i) {
+      if (use[i]) {
+        sxx += (x[i] - x_mean) * (x[i] - x_mean);
+        sxy += (x[i] - x_mean) * (y[i] - y_mean);
+      }
+    }
+
+    rate = m_nominal_clock_frequency_hz;
+    rate_fitted = fit_rate && n_used >= 3 && sxx > 0.;
+    if (rate_fitted) {
+      rate = std::clamp(sxy / sxx,
+                        m_nominal_clock_frequency_hz * (1. - s_max_rate_deviation),
+                        m_nominal_clock_frequency_hz * (1. + s_max_rate_deviation));
+    }
+    offset = y_mean - rate * x_mean;
+
+    double sum_r2 = 0.;
+    for (size_t i = 0; i < n_points; ++i) {
+      if (use[i]) {
+        double r = y[i] - offset - rate * x[i];
+        sum_r2 += r * r;
+      }
+    }
+    size_t fitted_parameters = rate_fitted ? 2 : 1;
+    sigma = n_used > fitted_parameters ? std::sqrt(sum_r2 / (n_used - fitted_parameters)) : 0.;
+  };
+
+  // Decide which points to use with a robust Theil-Sen fit (median
+  // of the pairwise slopes, median offset), rejecting points far from
+  // it in units of the median absolute deviation. Then do an ordinary
+  // least-squares fit to the remaining points
+  if (n_points >= 3) {
+    double robust_rate = m_nominal_clock_frequency_hz;
+    if (fit_rate) {
+      std::vector<double> slopes;
+      slopes.reserve(n_points * (n_points - 1) / 2);
+      for (size_t i = 0; i < n_points; ++i) {
+        for (size_t j = i + 1; j < n_points; ++j) {
+          if (std::abs(x[j] - x[i]) > 1e-3) {
+            slopes.push_back((y[j] - y[i]) / (x[j] - x[i]));
+          }
+        }
+      }
+      if (!slopes.empty()) {
+        std::nth_element(slopes.begin(), slopes.begin() + slopes.size() / 2, slopes.end());
+        robust_rate = std::clamp(slopes[slopes.size() / 2],
+                                 m_nominal_clock_frequency_hz * (1. - s_max_rate_deviation),
+                                 m_nominal_clock_frequency_hz * (1. + s_max_rate_deviation));
+      }
+    }
+
+    std::vector<double> intercepts(n_points);
+    for (size_t i = 0; i < n_points; ++i) {
+      intercepts[i] = y[i] - robust_rate * x[i];
+    }
+    std::vector<double> sorted(intercepts);
+    std::nth_element(sorted.begin(), sorted.begin() + n_points / 2, sorted.end());
+    const double robust_offset = sorted[n_points / 2];
+
+    std::vector<double> abs_residuals(n_points);
+    for (size_t i = 0; i < n_points; ++i) {
+      abs_residuals[i] = std::abs(intercepts[i] - robust_offset);
+    }
+    sorted = abs_residuals;
+    std::nth_element(sorted.begin(), sorted.begin() + n_points / 2, sorted.end());
+    // 2 us of host-time resolution is the smallest spread we can hope for
+    const double threshold = std::max(4. * 1.4826 * sorted[n_points / 2], 2e-6 * m_nominal_clock_frequency_hz);
+
+    size_t n_outliers = 0;
+    for (size_t i = 0; i < n_points; ++i) {
+      use[i] = abs_residuals[i] <= threshold;
+      n_outliers += use[i] ? 0 : 1;
+    }
+    if (n_outliers > 0) {
+      TLOG_DEBUG(10) << "Fitting without " << n_outliers << " outliers out of " << n_points << " points";
+    }
+  }
+
+  least_squares();
+
+  // The host clock only has us resolution
+  sigma = std::max(sigma, 1e-6 * m_nominal_clock_frequency_hz);
+
+  const double x_now = (now - reference.host_time) * 1e-9;
+  double error_at_now = 0., rate_error = 0.;
+  if (rate_fitted) {
+    error_at_now = s_error_bound_sigmas * sigma * std::sqrt(1. / n_used + (x_now - x_mean) * (x_now - x_mean) / sxx);
+    rate_error = s_error_bound_sigmas * sigma / std::sqrt(sxx);
+  } else {
+    rate_error = s_default_rate_uncertainty * m_nominal_clock_frequency_hz;
+    error_at_now = s_error_bound_sigmas * sigma / std::sqrt(n_used) + rate_error * std::abs(x_now - x_mean);
+  }
+
+  const double fit_at_now = offset + rate * x_now; // relative to reference.daq_time
+
+  ClockModelSnapshot snapshot;
+  snapshot.valid = true;
+  snapshot.anchor_host_time = now;
+  snapshot.slew_end_host_time = now;
+  snapshot.rate_hz = rate;
+  snapshot.slew_rate_hz = rate;
+  snapshot.error_at_anchor = error_at_now;
+  snapshot.rate_error_hz = rate_error;
+  snapshot.anchor_daq_time = reference.daq_time + std::llround(fit_at_now);
+
+  if (m_snapshot.valid) {
+    // Carry on from where the old model is now, and slew towards the
+    // new fit rather than jumping, unless the difference is very large
+    dfmessages::timestamp_t old_at_now = m_snapshot.predict(now);
+    double correction = static_cast<double>(static_cast<int64_t>(old_at_now - reference.daq_time)) - fit_at_now;
+    if (std::abs(correction) <= s_max_slew_correction * m_nominal_clock_frequency_hz) {
+      double slew_duration = std::abs(correction) / (s_max_slew_fraction * rate);
+      snapshot.anchor_daq_time = old_at_now;
+      snapshot.slew_correction = correction;
+      snapshot.slew_end_host_time = now + std::llround(slew_duration * 1e9);
+      snapshot.slew_rate_hz = slew_duration > 0. ? rate - correction / slew_duration : rate;
+    } else {
+      TLOG_DEBUG(5) << "Clock model correction of " << correction << " ticks is too large to slew, jumping";
+    }
+  }
+
+  m_snapshot = snapshot;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -0,0 +1,72 @@
+/**
+ * @file ClockModelEstimatorBase.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/ClockModelEstimatorBase.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <memory>
+#include <utility>
+
+#define TRACE_NAME "ClockModelEstimatorBase" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+ClockModelEstimatorBase::ClockModelEstimatorBase(std::shared_ptr<Clock> clock)
+  : TimestampEstimatorBase(std::move(clock))
+{}
+
+dfmessages::timestamp_t
+ClockModelEstimatorBase::get_timestamp_estimate() const
+{
+  ClockModelSnapshot snapshot = load_snapshot();
+  if (!snapshot.valid) {
+    return dfmessages::TypeDefaults::s_invalid_timestamp;
+  }
+
+  dfmessages::timestamp_t new_timestamp = snapshot.predict(get_clock().steady_time_ns());
+
+  // Don't ever decrease the timestamp: if another caller has already
+  // been given a larger estimate, give out that one instead
+  dfmessages::timestamp_t current_estimate = m_current_timestamp_estimate.load();
+  while (current_estimate == dfmessages::TypeDefaults::s_invalid_timestamp || new_timestamp > current_estimate) {
+    if (m_current_timestamp_estimate.compare_exchange_weak(current_estimate, new_timestamp)) {
+      return new_timestamp;
+    }
+  }
+  if (new_timestamp < current_estimate) {
+    ++m_refused_backward_steps;
+    TLOG_DEBUG(5) << "Not updating timestamp estimate backwards from " << current_estimate << " to " << new_timestamp;
+  }
+  return current_estimate;
+}
+
+dfmessages::timestamp_t
+ClockModelEstimatorBase::get_timestamp_estimate_error() const
+{
+  ClockModelSnapshot snapshot = load_snapshot();
+  if (!snapshot.valid) {
+    return dfmessages::TypeDefaults::s_invalid_timestamp;
+  }
+  return snapshot.error_bound(get_clock().steady_time_ns());
+}
+
+bool
+ClockModelEstimatorBase::get_host_time_for_timestamp(dfmessages::timestamp_t ts, int64_t& steady_time_ns) const
+{
+  ClockModelSnapshot snapshot = load_snapshot();
+  if (!snapshot.valid) {
+    return false;
+  }
+  steady_time_ns = snapshot.host_time_for(ts);
+  return true;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
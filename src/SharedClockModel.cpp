@@ -0,0 +1,148 @@
+/**
+ * @file SharedClockModel.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/SharedClockModel.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRACE_NAME "SharedClockModel" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+SharedClockModelPublisher::SharedClockModelPublisher(const std::string& shm_name,
+                                                     uint64_t clock_frequency_hz) // NOLINT(build/unsigned)
+  : m_shm_name(shm_name)
+  , m_segment(nullptr)
+{
+  int fd = shm_open(m_shm_name.c_str(), O_CREAT | O_RDWR, 0664);
+  if (fd < 0) {
+    throw SharedMemoryIssue(ERS_HERE, m_shm_name, std::string("shm_open failed: ") + std::strerror(errno));
+  }
+  if (ftruncate(fd, sizeof(SharedClockModelSegment)) != 0) {
+    int error = errno;
+    close(fd);
+    throw SharedMemoryIssue(ERS_HERE, m_shm_name, std::string("ftruncate failed: ") + std::strerror(error));
+  }
+  void* mapping = mmap(nullptr, sizeof(SharedClockModelSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw SharedMemoryIssue(ERS_HERE, m_shm_name, std::string("mmap failed: ") + std::strerror(errno));
+  }
+  m_segment = static_cast<SharedClockModelSegment*>(mapping);
+
+  // Re-use a segment left by a previous publisher if it is compatible,
+  // so that its readers don't see the sequence number start again. Its
+  // model may be stale by now, so it is withdrawn until we publish ours
+  if (m_segment->magic.load(std::memory_order_acquire) == SharedClockModelSegment::s_magic &&
+      m_segment->version == SharedClockModelSegment::s_version &&
+      m_segment->clock_frequency_hz == clock_frequency_hz) {
+    TLOG_DEBUG(5) << "Publishing the clock model to existing shared memory segment " << m_shm_name;
+    publish(ClockModelSnapshot());
+    return;
+  }
+
+  TLOG_DEBUG(5) << "Initialising shared memory segment " << m_shm_name;
+  m_segment->magic.store(0, std::memory_order_release);
+  m_segment->version = SharedClockModelSegment::s_version;
+  m_segment->segment_size = sizeof(SharedClockModelSegment);
+  m_segment->clock_frequency_hz = clock_frequency_hz;
+  new (&m_segment->snapshot) SeqLock<ClockModelSnapshot>(ClockModelSnapshot());
+  m_segment->magic.store(SharedClockModelSegment::s_magic, std::memory_order_release);
+}
+
+SharedClockModelPublisher::~SharedClockModelPublisher()
+{
+  // Nobody keeps the model up to date from now on
+  publish(ClockModelSnapshot());
+  munmap(m_segment, sizeof(SharedClockModelSegment));
+}
+
+SharedClockModelReader::SharedClockModelReader(const std::string& shm_name,
+                                               uint64_t clock_frequency_hz) // NOLINT(build/unsigned)
+  : m_shm_name(shm_name)
+  , m_clock_frequency_hz(clock_frequency_hz)
+  , m_mapping(nullptr)
+  , m_mapping_size(0)
+  , m_segment(nullptr)
+{
+  attach();
+}
+
+SharedClockModelReader::~SharedClockModelReader()
+{
+  if (m_mapping) {
+    munmap(m_mapping, m_mapping_size);
+  }
+}
+
+bool
+SharedClockModelReader::attach()
+{
+  if (m_segment.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  if (!m_mapping) {
+    int fd = shm_open(m_shm_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      TLOG_DEBUG(5) << "Shared memory segment " << m_shm_name << " does not exist yet";
+      return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SharedClockModelSegment)) {
+      close(fd);
+      return false;
+    }
+    void* mapping = mmap(nullptr, sizeof(SharedClockModelSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      ers::warning(SharedMemoryIssue(ERS_HERE, m_shm_name, std::string("mmap failed: ") + std::strerror(errno)));
+      return false;
+    }
+    m_mapping = mapping;
+    m_mapping_size = sizeof(SharedClockModelSegment);
+  }
+
+  // The publisher may still be initialising the segment
+  auto segment = static_cast<const SharedClockModelSegment*>(m_mapping);
+  if (segment->magic.load(std::memory_order_acquire) != SharedClockModelSegment::s_magic) {
+    return false;
+  }
+  if (segment->version != SharedClockModelSegment::s_version ||
+      segment->segment_size != sizeof(SharedClockModelSegment)) {
+    ers::warning(SharedMemoryIssue(ERS_HERE, m_shm_name, "incompatible segment version"));
+    return false;
+  }
+  if (segment->clock_frequency_hz != m_clock_frequency_hz) {
+    ers::warning(SharedMemoryIssue(ERS_HERE,
+                                   m_shm_name,
+                                   "segment clock frequency is " + std::to_string(segment->clock_frequency_hz) +
+                                     " Hz, expected " + std::to_string(m_clock_frequency_hz) + " Hz"));
+    return false;
+  }
+
+  TLOG_DEBUG(5) << "Attached to shared memory segment " << m_shm_name;
+  m_segment.store(segment, std::memory_order_release);
+  return true;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
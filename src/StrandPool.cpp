@@ -0,0 +1,153 @@
+/**
+ * @file StrandPool.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/StrandPool.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
+#define TRACE_NAME "StrandPool" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+StrandPool::StrandPool(size_t n_workers,
+                       const std::string& thread_name,
+                       size_t n_urgent_workers,
+                       int urgent_priority)
+  : m_n_urgent_workers(n_urgent_workers)
+  , m_urgent_priority(urgent_priority)
+{
+  n_workers = std::max<size_t>(n_workers, 1);
+  for (size_t i = 0; i < n_workers + n_urgent_workers; ++i) {
+    bool urgent_only = i >= n_workers;
+    m_workers.emplace_back(&StrandPool::worker_fn, this, urgent_only);
+    // thread names are limited to 15 characters
+    auto name = thread_name.substr(0, 11) + (urgent_only ? "-u" : "-") + std::to_string(i);
+    pthread_setname_np(m_workers.back().native_handle(), name.c_str());
+  }
+  TLOG_DEBUG(0) << "Started " << n_workers << " " << thread_name << " workers, and " << n_urgent_workers
+                << " for urgent tasks";
+}
+
+StrandPool::~StrandPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+  }
+  m_work_cv.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void
+StrandPool::post(const std::string& strand_name, task_t task, int priority)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    auto strand = m_strands.try_emplace(strand_name).first;
+    auto& tasks = strand->second.tasks;
+    // after every waiting task with at least the same priority
+    auto position = std::find_if(
+      tasks.begin(), tasks.end(), [priority](const Task& waiting) { return waiting.priority < priority; });
+    tasks.insert(position, Task{ priority, std::move(task) });
+    ++m_pending_tasks;
+    if (!strand->second.scheduled) {
+      strand->second.scheduled = true;
+      m_ready.push_back(strand);
+    }
+  }
+  // the urgent workers only wake for urgent tasks, so wake them all and let them check
+  m_work_cv.notify_all();
+}
+
+void
+StrandPool::wait_idle()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_idle_cv.wait(lk, [&]() { return m_pending_tasks == 0; });
+}
+
+size_t
+StrandPool::get_number_of_pending_tasks() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_pending_tasks;
+}
+
+std::deque<StrandPool::strand_iterator_t>::iterator
+StrandPool::next_ready_strand(int min_priority)
+{
+  // there are only ever a few strands, so just look at all of them. on a tie, the one which has waited longest wins
+  auto next = m_ready.end();
+  for (auto it = m_ready.begin(); it != m_ready.end(); ++it) {
+    int priority = (*it)->second.tasks.front().priority;
+    if (priority >= min_priority && (next == m_ready.end() || priority > (*next)->second.tasks.front().priority)) {
+      next = it;
+    }
+  }
+  return next;
+}
+
+void
+StrandPool::worker_fn(bool urgent_only)
+{
+  const int min_priority = urgent_only ? m_urgent_priority : std::numeric_limits<int>::min();
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  while (true) {
+    auto next = m_ready.end();
+    // when stopping, a regular worker stays until every posted task has run: a strand that another worker is
+    // running is not in m_ready, and may still have tasks which only a regular worker can pick up
+    m_work_cv.wait(lk, [&]() {
+      next = next_ready_strand(min_priority);
+      return next != m_ready.end() || (m_stop && (urgent_only || m_pending_tasks == 0));
+    });
+    if (next == m_ready.end()) {
+      // stopping, and nothing is left for this worker to run
+      return;
+    }
+
+    auto strand = *next;
+    m_ready.erase(next);
+    task_t task = std::move(strand->second.tasks.front().task);
+    strand->second.tasks.pop_front();
+
+    lk.unlock();
+    try {
+      task();
+    } catch (const std::exception& excpt) {
+      ers::error(StrandTaskFailed(ERS_HERE, strand->first, excpt));
+    }
+    lk.lock();
+
+    --m_pending_tasks;
+    if (strand->second.tasks.empty()) {
+      strand->second.scheduled = false;
+    } else {
+      m_ready.push_back(strand);
+      m_work_cv.notify_all();
+    }
+    if (m_pending_tasks == 0) {
+      m_idle_cv.notify_all();
+      // lets the regular workers exit if the pool is stopping
+      m_work_cv.notify_all();
+    }
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -0,0 +1,106 @@
+/**
+ * @file TimeSyncSourceTracker.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimeSyncSourceTracker.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#define TRACE_NAME "TimeSyncSourceTracker" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+TimeSyncSourceTracker::TimeSyncSourceTracker(int64_t outlier_threshold)
+  : m_outlier_threshold(outlier_threshold)
+{}
+
+bool
+TimeSyncSourceTracker::add(pid_t source, int64_t residual, bool have_model, int64_t delivery_lag, int64_t now)
+{
+  auto& state = m_sources[source];
+  ++state.received;
+  state.delivery_lag = delivery_lag;
+  state.last_arrival = now;
+
+  if (have_model) {
+    state.residuals.push_back(residual);
+    while (state.residuals.size() > s_residual_window) {
+      state.residuals.pop_front();
+    }
+    std::vector<int64_t> sorted(state.residuals.begin(), state.residuals.end());
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    state.offset = sorted[sorted.size() / 2];
+  }
+
+  classify(now);
+
+  bool use = true;
+  if (state.residuals.size() >= s_min_residuals) {
+    use = !state.outlier;
+  } else if (have_model) {
+    // Not judged yet: trust it only if it agrees with the model, unless
+    // there are no judged sources which the model could be based on
+    bool judged_sources = std::any_of(m_sources.begin(), m_sources.end(), [&](const auto& entry) {
+      return entry.second.residuals.size() >= s_min_residuals && !entry.second.outlier &&
+             now - entry.second.last_arrival < s_source_timeout;
+    });
+    use = !judged_sources || std::abs(residual) <= m_outlier_threshold;
+  }
+
+  if (!use) {
+    ++state.rejected;
+  }
+  return use;
+}
+
+void
+TimeSyncSourceTracker::classify(int64_t now)
+{
+  std::vector<Source*> judged;
+  std::vector<pid_t> judged_ids;
+  for (auto& [id, state] : m_sources) {
+    if (state.residuals.size() >= s_min_residuals && now - state.last_arrival < s_source_timeout) {
+      judged.push_back(&state);
+      judged_ids.push_back(id);
+    }
+  }
+
+  // A source belongs to the majority if it agrees with more than half of the judged sources (itself included)
+  std::vector<size_t> agreeing(judged.size(), 0);
+  bool have_majority = false;
+  for (size_t i = 0; i < judged.size(); ++i) {
+    for (size_t j = 0; j < judged.size(); ++j) {
+      if (std::abs(judged[i]->offset - judged[j]->offset) <= m_outlier_threshold) {
+        ++agreeing[i];
+      }
+    }
+    have_majority = have_majority || 2 * agreeing[i] > judged.size();
+  }
+
+  for (size_t i = 0; i < judged.size(); ++i) {
+    bool outlier = judged.size() > 1 && have_majority && 2 * agreeing[i] <= judged.size();
+    if (outlier && !judged[i]->outlier) {
+      ers::warning(TimeSyncSourceOutlier(ERS_HERE, judged_ids[i], judged[i]->offset));
+    } else if (!outlier && judged[i]->outlier) {
+      TLOG() << "TimeSyncs from source " << judged_ids[i] << " agree with the other sources again";
+    }
+    judged[i]->outlier = outlier;
+  }
+  if (judged.size() > 1 && !have_majority) {
+    TLOG_DEBUG(5) << "No majority among " << judged.size() << " TimeSync sources, using all of them";
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -9,98 +9,247 @@
 #include "timinglibs/TimestampEstimator.hpp"
 //#include "trigger/Issues.hpp"
 
+#include "timinglibs/timestampestimatorinfo/InfoNljs.hpp"
+#include "timinglibs/timestampestimatorinfo/InfoStructs.hpp"
+
 #include "logging/Logging.hpp"
 
+#include <chrono>
+#include <cstdlib>
 #include <memory>
+#include <string>
+#include <utility>
 
 #define TRACE_NAME "TimestampEstimator" // NOLINT
 
 namespace dunedaq {
 namespace timinglibs {
 TimestampEstimator::TimestampEstimator(std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>>& time_sync_source,
-                                       uint64_t clock_frequency_hz) // NOLINT(build/unsigned)
-  : m_running_flag(true)
+                                       uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                       std::shared_ptr<Clock> clock,
+                                       dfmessages::run_number_t run_number)
+  : ClockModelEstimatorBase(std::move(clock))
+  , m_clock_model(clock_frequency_hz)
+  , m_source_tracker(static_cast<int64_t>(clock_frequency_hz * s_source_outlier_threshold))
+  , m_run_number(run_number)
+  , m_running_flag(true)
   , m_clock_frequency_hz(clock_frequency_hz)
   , m_estimator_thread(&TimestampEstimator::estimator_thread_fn, this, std::ref(time_sync_source))
 {
   pthread_setname_np(m_estimator_thread.native_handle(), "tde-ts-est");
 }
 
+TimestampEstimator::TimestampEstimator(const std::string& time_sync_queue_name,
+                                       uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                       std::shared_ptr<Clock> clock,
+                                       dfmessages::run_number_t run_number)
+  : ClockModelEstimatorBase(std::move(clock))
+  , m_clock_model(clock_frequency_hz)
+  , m_source_tracker(static_cast<int64_t>(clock_frequency_hz * s_source_outlier_threshold))
+  , m_run_number(run_number)
+  , m_running_flag(true)
+  , m_clock_frequency_hz(clock_frequency_hz)
+  , m_owned_time_sync_source(new appfwk::DAQSource<dfmessages::TimeSync>(time_sync_queue_name))
+  , m_estimator_thread(&TimestampEstimator::estimator_thread_fn, this, std::ref(m_owned_time_sync_source))
+{
+  pthread_setname_np(m_estimator_thread.native_handle(), "tde-ts-est");
+}
+
+TimestampEstimator::TimestampEstimator(uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                       std::shared_ptr<Clock> clock)
+  : ClockModelEstimatorBase(std::move(clock))
+  , m_clock_model(clock_frequency_hz)
+  , m_source_tracker(static_cast<int64_t>(clock_frequency_hz * s_source_outlier_threshold))
+  , m_running_flag(false)
+  , m_clock_frequency_hz(clock_frequency_hz)
+{}
+
 TimestampEstimator::~TimestampEstimator()
 {
+  stop_async_waits();
   m_running_flag.store(false);
-  m_estimator_thread.join();
+  if (m_estimator_thread.joinable()) {
+    m_estimator_thread.join();
+  }
 }
 
 void
-TimestampEstimator::estimator_thread_fn(std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>>& time_sync_source)
+TimestampEstimator::add_timesync(const dfmessages::TimeSync& timesync)
 {
-  // This loop is a hack to deal with the fact that there might be
-  // leftover TimeSync messages from the previous run, because
-  // ModuleLevelTrigger is stopped before the readout modules
-  // that send the TimeSyncs. So we pop everything we can at
-  // startup. This will definitely get all of the TimeSyncs from the
-  // previous run. It *may* also get TimeSyncs from the current run,
-  // which we drop on the floor. This is fairly harmless: it'll just
-  // slightly delay us getting to the point where we actually start
-  // making the timestamp estimate
-  while (time_sync_source->can_pop()) {
-    dfmessages::TimeSync t{ dfmessages::TypeDefaults::s_invalid_timestamp };
-    time_sync_source->pop(t);
+  int64_t time_now = get_clock().system_time_ns();
+  int64_t timesync_host_time = static_cast<int64_t>(timesync.system_time) * 1000;
+  ++m_received_timesyncs;
+  m_last_timesync_arrival.store(get_clock().steady_time_ns());
+  auto run_number = m_run_number.load();
+  if (run_number != 0 && timesync.run_number != 0 && timesync.run_number != run_number) {
+    ++m_discarded_timesyncs;
+    TLOG_DEBUG(10) << "Ignoring TimeSync from run " << timesync.run_number << " during run " << run_number;
+    return;
+  }
+  if (time_now < timesync_host_time) {
+    ++m_discarded_timesyncs;
+    ers::error(InvalidTimeSync(ERS_HERE));
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(m_clock_model_mutex);
+  const ClockModelSnapshot& model = m_clock_model.get_snapshot();
+  bool had_model = model.valid;
+  // residual is daq_time - estimate
+  int64_t residual = had_model ? static_cast<int64_t>(timesync.daq_time - model.predict(timesync_host_time)) : 0;
+
+  if (!m_source_tracker.add(
+        timesync.source_pid, residual, had_model, time_now - timesync_host_time, time_now)) {
+    ++m_discarded_timesyncs;
+    TLOG_DEBUG(10) << "Ignoring TimeSync from outlier source " << timesync.source_pid << ", residual " << residual
+                   << " ticks";
+    return;
+  }
+
+  m_clock_model.add_point(timesync.daq_time, timesync_host_time, time_now);
+  TLOG_DEBUG(10) << "TimeSync residual with respect to the clock model: " << residual
+                 << " ticks, fitted rate: " << m_clock_model.get_snapshot().rate_hz << " Hz";
+  if (had_model) {
+    if (residual <= 0) {
+      m_residual_ahead_histogram.record(-residual);
+    } else {
+      m_residual_behind_histogram.record(residual);
+    }
+    m_residual_histogram.record(std::abs(residual));
+  }
+  m_model_points.store(m_clock_model.get_number_of_points());
+
+  if (m_most_recent_timesync.daq_time == dfmessages::TypeDefaults::s_invalid_timestamp ||
+      timesync.daq_time > m_most_recent_timesync.daq_time) {
+    m_most_recent_timesync = timesync;
+  }
+
+  // TimeSync system times are on the system clock, but we don't want
+  // the estimate to follow steps of the system clock between
+  // TimeSyncs, so publish the model on the monotonic clock
+  ClockModelSnapshot snapshot = m_clock_model.get_snapshot();
+  int64_t steady_offset = get_clock().steady_time_ns() - get_clock().system_time_ns();
+  snapshot.anchor_host_time += steady_offset;
+  snapshot.slew_end_host_time += steady_offset;
+  m_published_snapshot.store(snapshot);
+  if (m_shared_memory_publisher) {
+    m_shared_memory_publisher->publish(snapshot);
+  }
+  notify_waiters();
+}
+
+void
+TimestampEstimator::set_run_number(dfmessages::run_number_t run_number)
+{
+  TLOG_DEBUG(5) << "Using TimeSyncs from run " << run_number;
+  m_run_number.store(run_number);
+}
+
+void
+TimestampEstimator::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  timestampestimatorinfo::Info info;
+  info.received_timesyncs = m_received_timesyncs.load();
+  info.discarded_timesyncs = m_discarded_timesyncs.load();
+  auto last_arrival = m_last_timesync_arrival.load();
+  info.time_since_last_timesync = last_arrival != 0 ? (get_clock().steady_time_ns() - last_arrival) / 1000 : 0;
+
+  info.residual_p50 = m_residual_histogram.percentile(0.5);
+  info.residual_p99 = m_residual_histogram.percentile(0.99);
+  info.residual_max = m_residual_histogram.max();
+  info.residual_ahead_histogram = m_residual_ahead_histogram.octave_counts();
+  info.residual_behind_histogram = m_residual_behind_histogram.octave_counts();
+
+  info.refused_backward_steps = get_refused_backward_steps();
+  ClockModelSnapshot snapshot = m_published_snapshot.load();
+  info.fitted_rate = snapshot.valid ? snapshot.rate_hz : 0.;
+  info.estimate_error = snapshot.valid ? snapshot.error_bound(get_clock().steady_time_ns()) : 0;
+  info.model_points = m_model_points.load();
+
+  {
+    std::lock_guard<std::mutex> lk(m_clock_model_mutex);
+    int64_t now = get_clock().system_time_ns();
+    for (auto& [id, source] : m_source_tracker.get_sources()) {
+      timestampestimatorinfo::SourceInfo source_info;
+      source_info.source_pid = id;
+      source_info.received = source.received;
+      source_info.rejected = source.rejected;
+      source_info.offset = source.offset;
+      source_info.delivery_lag = source.delivery_lag / 1000;
+      source_info.time_since_last = (now - source.last_arrival) / 1000;
+      source_info.outlier = source.outlier;
+      info.sources.push_back(source_info);
+    }
+  }
+
+  ci.add(info);
+}
+
+void
+TimestampEstimator::publish_to_shared_memory(const std::string& shm_name)
+{
+  std::lock_guard<std::mutex> lk(m_clock_model_mutex);
+  if (m_shared_memory_publisher && m_shared_memory_publisher->get_name() == shm_name) {
+    return;
   }
+  m_shared_memory_publisher.reset(new SharedClockModelPublisher(shm_name, m_clock_frequency_hz));
+  m_shared_memory_publisher->publish(m_published_snapshot.load());
+}
 
-  dfmessages::TimeSync most_recent_timesync{ dfmessages::TypeDefaults::s_invalid_timestamp };
-  m_current_timestamp_estimate.store(dfmessages::TypeDefaults::s_invalid_timestamp);
+void
+TimestampEstimator::estimator_thread_fn(std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>>& time_sync_source)
+{
+  // There may be TimeSync messages left over from the previous run
+  // in the queue, because ModuleLevelTrigger is stopped before the
+  // readout modules that send the TimeSyncs. We don't drain them
+  // blindly, since that can throw away TimeSyncs from the current run
+  // too: once the hosting module has told us the run number, TimeSyncs
+  // from other runs are dropped in add_timesync() instead
 
   // time_sync_source_ is connected to an MPMC queue with multiple
-  // writers. We read whatever we can off it, and the item with the
-  // largest timestamp "wins"
-  while (m_running_flag.load()) {
-    // First, update the latest timestamp
-    while (time_sync_source->can_pop()) {
-      dfmessages::TimeSync t{ dfmessages::TypeDefaults::s_invalid_timestamp };
-      time_sync_source->pop(t);
-      dfmessages::timestamp_t estimate = m_current_timestamp_estimate.load();
-      dfmessages::timestamp_diff_t diff = estimate - t.daq_time;
-      TLOG_DEBUG(10) << "Got a TimeSync timestamp = " << t.daq_time << ", system time = " << t.system_time
-                     << " when current timestamp estimate was " << estimate << ". diff=" << diff;
-      if (most_recent_timesync.daq_time == dfmessages::TypeDefaults::s_invalid_timestamp ||
-          t.daq_time > most_recent_timesync.daq_time) {
-        most_recent_timesync = t;
-      }
+  // writers. We block waiting for the next TimeSync and add each one
+  // to the clock model as soon as it arrives. Between arrivals,
+  // get_timestamp_estimate() extrapolates from the model on demand,
+  // so there is nothing to do here
+  //
+  // Warn the user, once per episode, if the latest TimeSync is more
+  // than 1s behind current system time, whether it has just arrived
+  // late or none has arrived at all. This could be a sign of an
+  // issue, e.g. machine times out of sync, or just that the run has
+  // stopped
+  bool warned_late = false;
+  auto check_late = [&](uint64_t system_time) { // NOLINT(build/unsigned)
+    auto time_now = static_cast<uint64_t>(get_clock().system_time_ns() / 1000); // NOLINT(build/unsigned)
+    if (system_time == 0 || time_now <= system_time + 1000000) {
+      warned_late = false;
+    } else if (!warned_late) {
+      ers::warning(LateTimeSync(ERS_HERE, time_now - system_time));
+      warned_late = true;
     }
+  };
 
-    if (most_recent_timesync.daq_time != dfmessages::TypeDefaults::s_invalid_timestamp) {
-      // Update the current timestamp estimate, based on the most recently-read TimeSync
-      using namespace std::chrono;
-      // std::chrono is the worst
-      auto time_now =
-        static_cast<uint64_t>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count()); // NOLINT
-      if (time_now < most_recent_timesync.system_time) {
-        ers::error(InvalidTimeSync(ERS_HERE));
-      } else {
-        
-        auto delta_time = time_now - most_recent_timesync.system_time;
-        TLOG_DEBUG(10) << "Time diff between current system and latest TimeSync system time [us]: " << delta_time;
-        
-        // Warn user if current system time is more than 1s ahead of latest TimeSync system time. This could be a sign of an issue, e.g. machine times out of sync
-        if (delta_time > 1e6) ers::warning(LateTimeSync(ERS_HERE, delta_time));
-
-        const dfmessages::timestamp_t new_timestamp =
-          most_recent_timesync.daq_time + delta_time * m_clock_frequency_hz / 1000000;
-        // Don't ever decrease the timestamp; just wait until enough
-        // time passes that we want to increase it
-        if (m_current_timestamp_estimate.load() == dfmessages::TypeDefaults::s_invalid_timestamp ||
-            new_timestamp >= m_current_timestamp_estimate.load()) {
-          m_current_timestamp_estimate.store(new_timestamp);
-        } else {
-          TLOG_DEBUG(5) << "Not updating timestamp estimate backwards from " << m_current_timestamp_estimate.load() << " to "
-                 << new_timestamp;
-        }
+  while (m_running_flag.load()) {
+    dfmessages::TimeSync t{ dfmessages::TypeDefaults::s_invalid_timestamp };
+    try {
+      time_sync_source->pop(t, s_timesync_wait_timeout);
+    } catch (const appfwk::QueueTimeoutExpired&) {
+      uint64_t most_recent_system_time = 0; // NOLINT(build/unsigned)
+      {
+        std::lock_guard<std::mutex> lk(m_clock_model_mutex);
+        most_recent_system_time = m_most_recent_timesync.system_time;
+      }
+      if (most_recent_system_time != 0) {
+        check_late(most_recent_system_time);
       }
+      continue;
     }
+    check_late(t.system_time);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    dfmessages::timestamp_t estimate = get_timestamp_estimate();
+    dfmessages::timestamp_diff_t diff = estimate - t.daq_time;
+    TLOG_DEBUG(10) << "Got a TimeSync timestamp = " << t.daq_time << ", system time = " << t.system_time
+                   << " when current timestamp estimate was " << estimate << ". diff=" << diff;
+    add_timesync(t);
   }
 
   // Drain the input queue as best we can. We're not going to do
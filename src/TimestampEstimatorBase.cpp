@@ -8,20 +8,49 @@
 
 #include "timinglibs/TimestampEstimatorBase.hpp"
 
-#include <thread>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace dunedaq {
 namespace timinglibs {
+
+TimestampEstimatorBase::TimestampEstimatorBase(std::shared_ptr<Clock> clock)
+  : m_clock(clock ? std::move(clock) : SystemClock::get())
+{
+  // Re-check the waits whenever the clock's time jumps
+  m_clock_listener_id = m_clock->add_listener([this]() { notify_waiters(); });
+}
+
+TimestampEstimatorBase::~TimestampEstimatorBase()
+{
+  // Implementations should already have done this, as the timer thread
+  // can't safely use them any more by the time we get here
+  stop_async_waits();
+  m_clock->remove_listener(m_clock_listener_id);
+}
+
+void
+TimestampEstimatorBase::notify_waiters()
+{
+  // Take the lock so that a waiter can't miss the notification between
+  // checking the estimate and going to sleep
+  std::lock_guard<std::mutex> lk(m_wait_mutex);
+  m_wait_cv.notify_all();
+}
+
 TimestampEstimatorBase::WaitStatus
 TimestampEstimatorBase::wait_for_valid_timestamp(std::atomic<bool>& continue_flag)
 {
   if (!continue_flag.load())
     return TimestampEstimatorBase::kInterrupted;
 
-  while (continue_flag.load() && get_timestamp_estimate() == dfmessages::TypeDefaults::s_invalid_timestamp) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::unique_lock<std::mutex> lk(m_wait_mutex);
+  while (get_timestamp_estimate() == dfmessages::TypeDefaults::s_invalid_timestamp) {
     if (!continue_flag.load())
       return TimestampEstimatorBase::kInterrupted;
+    int64_t deadline = m_clock->steady_time_ns() + std::chrono::nanoseconds(s_max_wait_interval).count();
+    m_clock->wait_until(m_wait_cv, lk, deadline);
   }
 
   return TimestampEstimatorBase::kFinished;
@@ -33,15 +62,107 @@ TimestampEstimatorBase::wait_for_timestamp(dfmessages::timestamp_t ts, std::atom
   if (!continue_flag.load())
     return TimestampEstimatorBase::kInterrupted;
 
-  while (continue_flag.load() &&
-         (get_timestamp_estimate() < ts || get_timestamp_estimate() == dfmessages::TypeDefaults::s_invalid_timestamp)) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::unique_lock<std::mutex> lk(m_wait_mutex);
+  while (true) {
+    auto estimate = get_timestamp_estimate();
+    if (estimate != dfmessages::TypeDefaults::s_invalid_timestamp && estimate >= ts)
+      break;
     if (!continue_flag.load())
       return TimestampEstimatorBase::kInterrupted;
+
+    // Sleep until we expect ts to be reached, re-checking continue_flag at least every s_max_wait_interval
+    int64_t deadline = m_clock->steady_time_ns() + std::chrono::nanoseconds(s_max_wait_interval).count();
+    int64_t expected_time = 0;
+    if (get_host_time_for_timestamp(ts, expected_time) && expected_time < deadline)
+      deadline = expected_time;
+    m_clock->wait_until(m_wait_cv, lk, deadline);
   }
 
   return TimestampEstimatorBase::kFinished;
 }
 
+void
+TimestampEstimatorBase::call_at_timestamp(dfmessages::timestamp_t ts, TimestampCallback callback)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_wait_mutex);
+    if (!m_async_waits_stopped) {
+      m_timer_wheel.add(ts, std::move(callback));
+      if (!m_timer_thread.joinable()) {
+        m_timer_thread = std::thread(&TimestampEstimatorBase::timer_thread_fn, this);
+        pthread_setname_np(m_timer_thread.native_handle(), "tde-ts-timer");
+      }
+      m_wait_cv.notify_all();
+      return;
+    }
+  }
+  callback(TimestampEstimatorBase::kInterrupted);
+}
+
+std::future<TimestampEstimatorBase::WaitStatus>
+TimestampEstimatorBase::async_wait_for_timestamp(dfmessages::timestamp_t ts)
+{
+  auto promise = std::make_shared<std::promise<WaitStatus>>();
+  auto future = promise->get_future();
+  call_at_timestamp(ts, [promise](WaitStatus status) { promise->set_value(status); });
+  return future;
+}
+
+void
+TimestampEstimatorBase::stop_async_waits()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_wait_mutex);
+    m_async_waits_stopped = true;
+    m_wait_cv.notify_all();
+  }
+  if (m_timer_thread.joinable()) {
+    m_timer_thread.join();
+  }
+
+  std::vector<TimestampCallback> removed;
+  {
+    std::lock_guard<std::mutex> lk(m_wait_mutex);
+    m_timer_wheel.clear(removed);
+  }
+  for (auto& callback : removed) {
+    callback(TimestampEstimatorBase::kInterrupted);
+  }
+}
+
+void
+TimestampEstimatorBase::timer_thread_fn()
+{
+  std::vector<TimestampCallback> expired;
+  std::unique_lock<std::mutex> lk(m_wait_mutex);
+  while (!m_async_waits_stopped) {
+    if (m_timer_wheel.empty()) {
+      m_wait_cv.wait(lk);
+      continue;
+    }
+
+    int64_t deadline = m_clock->steady_time_ns() + std::chrono::nanoseconds(s_max_wait_interval).count();
+    auto estimate = get_timestamp_estimate();
+    if (estimate != dfmessages::TypeDefaults::s_invalid_timestamp) {
+      m_timer_wheel.advance(estimate, expired);
+      if (!expired.empty()) {
+        // Don't hold the lock while calling out, so that callbacks can add new timers
+        lk.unlock();
+        for (auto& callback : expired) {
+          callback(TimestampEstimatorBase::kFinished);
+        }
+        expired.clear();
+        lk.lock();
+        continue;
+      }
+
+      int64_t expected_time = 0;
+      if (get_host_time_for_timestamp(m_timer_wheel.next_expiry(), expected_time) && expected_time < deadline)
+        deadline = expected_time;
+    }
+    m_clock->wait_until(m_wait_cv, lk, deadline);
+  }
+}
+
 } // namespace timinglibs
 } // namespace dunedaq
@@ -0,0 +1,127 @@
+/**
+ * @file TimestampEstimatorHardware.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimestampEstimatorHardware.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#define TRACE_NAME "TimestampEstimatorHardware" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+TimestampEstimatorHardware::TimestampEstimatorHardware(TimestampReader reader,
+                                                       uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                                       std::chrono::milliseconds sample_interval,
+                                                       std::shared_ptr<Clock> clock)
+  : ClockModelEstimatorBase(clock)
+  , m_reader(std::move(reader))
+  , m_sample_interval(sample_interval)
+  , m_clock(clock ? std::move(clock) : SystemClock::get())
+  , m_clock_model(clock_frequency_hz)
+{
+  if (m_sample_interval.count() > 0) {
+    m_clock_listener_id = m_clock->add_listener([this]() {
+      std::lock_guard<std::mutex> lk(m_sampler_mutex);
+      m_sampler_cv.notify_all();
+    });
+    m_sampler_thread = std::thread(&TimestampEstimatorHardware::sampler_thread_fn, this);
+    pthread_setname_np(m_sampler_thread.native_handle(), "tde-ts-hw");
+  }
+}
+
+TimestampEstimatorHardware::~TimestampEstimatorHardware()
+{
+  stop_async_waits();
+  if (m_sampler_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(m_sampler_mutex);
+      m_stop_sampling = true;
+      m_sampler_cv.notify_all();
+    }
+    m_sampler_thread.join();
+    m_clock->remove_listener(m_clock_listener_id);
+  }
+}
+
+bool
+TimestampEstimatorHardware::sample()
+{
+  std::lock_guard<std::mutex> sample_lk(m_sample_mutex);
+
+  dfmessages::timestamp_t timestamp = 0;
+  int64_t before = m_clock->steady_time_ns();
+  try {
+    timestamp = m_reader();
+  } catch (const std::exception& excpt) {
+    // A failing endpoint would fail every sample: only warn at the first
+    // failure, and then every s_read_failure_warning_interval
+    ++m_read_failures;
+    if (m_read_failures == 1 || before >= m_next_read_failure_warning) {
+      ers::warning(EndpointTimestampReadFailed(ERS_HERE, m_read_failures, excpt));
+      m_next_read_failure_warning = before + std::chrono::nanoseconds(s_read_failure_warning_interval).count();
+    }
+    return false;
+  }
+  if (m_read_failures > 0) {
+    TLOG() << "Read the hardware timestamp again, after " << m_read_failures << " failed reads";
+    m_read_failures = 0;
+  }
+  int64_t after = m_clock->steady_time_ns();
+  if (timestamp == 0) {
+    TLOG_DEBUG(10) << "The hardware timestamp is not valid yet";
+    return false;
+  }
+
+  int64_t round_trip = after - before;
+  m_recent_round_trips.push_back(round_trip);
+  if (m_recent_round_trips.size() > s_round_trip_history) {
+    m_recent_round_trips.pop_front();
+  }
+  int64_t fastest = *std::min_element(m_recent_round_trips.begin(), m_recent_round_trips.end());
+  if (round_trip > s_max_round_trip_ratio * fastest &&
+      round_trip > std::chrono::nanoseconds(s_round_trip_tolerance).count()) {
+    TLOG_DEBUG(10) << "Dropping a timestamp sample whose read took " << round_trip << " ns, against " << fastest
+                   << " ns for the fastest recent one";
+    return false;
+  }
+
+  // The register was most likely read half way through the round trip
+  int64_t host_time = before + round_trip / 2;
+  m_clock_model.add_point(timestamp, host_time, after);
+  m_published_snapshot.store(m_clock_model.get_snapshot());
+  notify_waiters();
+  return true;
+}
+
+void
+TimestampEstimatorHardware::sampler_thread_fn()
+{
+  const int64_t interval = std::chrono::nanoseconds(m_sample_interval).count();
+  int64_t next_sample = m_clock->steady_time_ns();
+  std::unique_lock<std::mutex> lk(m_sampler_mutex);
+  while (!m_stop_sampling) {
+    if (m_clock->steady_time_ns() < next_sample) {
+      m_clock->wait_until(m_sampler_cv, lk, next_sample);
+      continue;
+    }
+    lk.unlock();
+    sample();
+    lk.lock();
+    // Don't try to catch up on samples missed while the host was busy
+    next_sample = std::max(next_sample + interval, m_clock->steady_time_ns());
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -0,0 +1,71 @@
+/**
+ * @file TimestampEstimatorRegistry.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimestampEstimatorRegistry.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <memory>
+#include <string>
+
+#define TRACE_NAME "TimestampEstimatorRegistry" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+TimestampEstimatorRegistry&
+TimestampEstimatorRegistry::get()
+{
+  static TimestampEstimatorRegistry s_registry;
+  return s_registry;
+}
+
+std::shared_ptr<TimestampEstimator>
+TimestampEstimatorRegistry::get_estimator(const std::string& time_sync_queue_name,
+                                          uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                          dfmessages::run_number_t run_number)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  auto& entry = m_estimators[key_t(time_sync_queue_name, clock_frequency_hz)];
+  auto estimator = entry.lock();
+  if (estimator) {
+    TLOG_DEBUG(5) << "Sharing the timestamp estimator for TimeSync queue " << time_sync_queue_name;
+    if (run_number != 0) {
+      estimator->set_run_number(run_number);
+    }
+    return estimator;
+  }
+
+  for (auto& [key, other] : m_estimators) {
+    if (key.first == time_sync_queue_name && key.second != clock_frequency_hz && !other.expired()) {
+      ers::warning(
+        TimestampEstimatorClockFrequencyMismatch(ERS_HERE, time_sync_queue_name, key.second, clock_frequency_hz));
+    }
+  }
+
+  TLOG_DEBUG(5) << "Creating a timestamp estimator for TimeSync queue " << time_sync_queue_name;
+  estimator = std::make_shared<TimestampEstimator>(time_sync_queue_name, clock_frequency_hz, nullptr, run_number);
+  entry = estimator;
+  return estimator;
+}
+
+size_t
+TimestampEstimatorRegistry::get_number_of_estimators()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (auto it = m_estimators.begin(); it != m_estimators.end();) {
+    it = it->second.expired() ? m_estimators.erase(it) : std::next(it);
+  }
+  return m_estimators.size();
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
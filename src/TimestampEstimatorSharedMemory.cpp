@@ -0,0 +1,56 @@
+/**
+ * @file TimestampEstimatorSharedMemory.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimestampEstimatorSharedMemory.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <chrono>
+#include <string>
+
+#define TRACE_NAME "TimestampEstimatorSharedMemory" // NOLINT
+
+namespace dunedaq {
+namespace timinglibs {
+
+TimestampEstimatorSharedMemory::TimestampEstimatorSharedMemory(const std::string& shm_name,
+                                                               uint64_t clock_frequency_hz) // NOLINT(build/unsigned)
+  : m_reader(shm_name, clock_frequency_hz)
+  , m_attached(false)
+  , m_next_attach_time(0)
+{
+  m_attached.store(m_reader.attach());
+  TLOG_DEBUG(0) << "Reading the timestamp estimate from shared memory segment " << shm_name
+                << (m_attached.load() ? "" : ", which is not published yet");
+}
+
+TimestampEstimatorSharedMemory::~TimestampEstimatorSharedMemory()
+{
+  stop_async_waits();
+}
+
+ClockModelSnapshot
+TimestampEstimatorSharedMemory::load_snapshot() const
+{
+  if (!m_attached.load(std::memory_order_acquire)) {
+    int64_t now = get_clock().steady_time_ns();
+    if (now < m_next_attach_time.load()) {
+      return ClockModelSnapshot();
+    }
+    std::lock_guard<std::mutex> lk(m_attach_mutex);
+    if (!m_reader.attach()) {
+      m_next_attach_time.store(now + std::chrono::nanoseconds(s_attach_retry_interval).count());
+      return ClockModelSnapshot();
+    }
+    m_attached.store(true, std::memory_order_release);
+  }
+  return m_reader.load();
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
@@ -11,24 +11,193 @@
 #include "logging/Logging.hpp"
 
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 namespace dunedaq {
 namespace timinglibs {
 
-TimestampEstimatorSystem::TimestampEstimatorSystem(uint64_t clock_frequency_hz) // NOLINT(build/unsigned)
+namespace {
+int64_t
+system_time_now_ns()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+int64_t
+steady_time_now_ns()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__x86_64__)
+bool
+has_invariant_tsc()
+{
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return edx & (1u << 8);
+}
+
+uint64_t // NOLINT(build/unsigned)
+read_tsc()
+{
+  return __rdtsc();
+}
+#else
+bool
+has_invariant_tsc()
+{
+  return false;
+}
+
+uint64_t // NOLINT(build/unsigned)
+read_tsc()
+{
+  return 0;
+}
+#endif
+
+// Read the TSC and the system and steady clocks at (nearly) the same
+// moment: take the times read inside the shortest of a few TSC intervals
+void
+sample_tsc_and_times(uint64_t& tsc, int64_t& system_time, int64_t& steady_time) // NOLINT(build/unsigned)
+{
+  uint64_t best_width = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+  for (int i = 0; i < 5; ++i) {
+    uint64_t before = read_tsc(); // NOLINT(build/unsigned)
+    int64_t system_now = system_time_now_ns();
+    int64_t steady_now = steady_time_now_ns();
+    uint64_t after = read_tsc(); // NOLINT(build/unsigned)
+    if (after - before < best_width) {
+      best_width = after - before;
+      tsc = before + (after - before) / 2;
+      system_time = system_now;
+      steady_time = steady_now;
+    }
+  }
+}
+} // namespace
+
+TimestampEstimatorSystem::TimestampEstimatorSystem(uint64_t clock_frequency_hz, bool use_tsc) // NOLINT(build/unsigned)
   : m_clock_frequency_hz(clock_frequency_hz)
+  , m_ticks_per_ns_num(clock_frequency_hz / std::gcd(clock_frequency_hz, uint64_t(1'000'000'000))) // NOLINT
+  , m_ns_per_tick_den(1'000'000'000 / std::gcd(clock_frequency_hz, uint64_t(1'000'000'000)))      // NOLINT
+  , m_use_tsc(use_tsc && has_invariant_tsc())
 {
-  TLOG_DEBUG(0) << "Clock frequency is " << m_clock_frequency_hz
-                << " clock_frequency_hz/1'000'000=" << (m_clock_frequency_hz / 1'000'000);
+  TLOG_DEBUG(0) << "Clock frequency is " << m_clock_frequency_hz << " Hz = " << m_ticks_per_ns_num << "/"
+                << m_ns_per_tick_den << " ticks/ns";
+  if (use_tsc && !m_use_tsc) {
+    TLOG() << "No invariant TSC on this CPU, reading the system clock for each timestamp estimate";
+  }
+  if (m_use_tsc) {
+    calibrate_tsc(nullptr);
+  }
+}
+
+TimestampEstimatorSystem::TimestampEstimatorSystem(uint64_t clock_frequency_hz, // NOLINT(build/unsigned)
+                                                   std::shared_ptr<Clock> clock)
+  : TimestampEstimatorBase(std::move(clock))
+  , m_clock_frequency_hz(clock_frequency_hz)
+  , m_ticks_per_ns_num(clock_frequency_hz / std::gcd(clock_frequency_hz, uint64_t(1'000'000'000))) // NOLINT
+  , m_ns_per_tick_den(1'000'000'000 / std::gcd(clock_frequency_hz, uint64_t(1'000'000'000)))      // NOLINT
+  , m_use_tsc(false)
+{}
+
+TimestampEstimatorSystem::~TimestampEstimatorSystem()
+{
+  stop_async_waits();
+}
+
+void
+TimestampEstimatorSystem::calibrate_tsc(const TscCalibration* previous) const
+{
+  TscCalibration calibration;
+  int64_t elapsed_cycles = 0;
+  int64_t elapsed_ns = 0;
+  do {
+    uint64_t start_tsc = 0; // NOLINT(build/unsigned)
+    int64_t start_system_time = 0;
+    int64_t start_steady_time = 0;
+    if (previous) {
+      // Measure the rate over the whole time since the last calibration
+      start_tsc = previous->tsc;
+      start_steady_time = previous->steady_time;
+    } else {
+      sample_tsc_and_times(start_tsc, start_system_time, start_steady_time);
+      std::this_thread::sleep_for(s_tsc_calibration_time);
+    }
+    sample_tsc_and_times(calibration.tsc, calibration.system_time, calibration.steady_time);
+    elapsed_cycles = static_cast<int64_t>(calibration.tsc - start_tsc);
+    elapsed_ns = calibration.steady_time - start_steady_time;
+    // Only the first calibration has nothing to fall back on, so it measures again
+  } while (!previous && (elapsed_cycles <= 0 || elapsed_ns <= 0));
+  calibration.ticks = ns_to_ticks(calibration.system_time);
+
+  if (elapsed_cycles <= 0 || elapsed_ns <= 0) {
+    // Nothing to measure, e.g. the TSC was read on a core whose TSC is
+    // slightly behind: keep the previous rate, and only re-anchor to
+    // the system time
+    calibration.ticks_per_cycle = previous->ticks_per_cycle;
+    calibration.recalibration_cycles = previous->recalibration_cycles;
+    m_tsc_calibration.store(calibration);
+    return;
+  }
+
+  double cycles_per_ns = static_cast<double>(elapsed_cycles) / static_cast<double>(elapsed_ns);
+  double ticks_per_ns = static_cast<double>(m_ticks_per_ns_num) / m_ns_per_tick_den;
+  calibration.ticks_per_cycle = static_cast<uint64_t>(ticks_per_ns / cycles_per_ns * 4294967296.); // NOLINT
+  calibration.recalibration_cycles =
+    static_cast<uint64_t>(cycles_per_ns * std::chrono::nanoseconds(s_tsc_recalibration_interval).count()); // NOLINT
+
+  if (!previous) {
+    TLOG_DEBUG(0) << "Calibrated the TSC at " << cycles_per_ns << " GHz";
+  }
+  m_tsc_calibration.store(calibration);
 }
 
 dfmessages::timestamp_t
 TimestampEstimatorSystem::get_timestamp_estimate() const
 {
-  auto now = std::chrono::system_clock::now().time_since_epoch();
-  auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(now);
-  return (m_clock_frequency_hz / 1'000'000) * now_us.count();
+  if (!m_use_tsc) {
+    return ns_to_ticks(get_clock().system_time_ns());
+  }
+
+  TscCalibration calibration = m_tsc_calibration.load();
+  int64_t cycles = static_cast<int64_t>(read_tsc() - calibration.tsc);
+  if (cycles < 0) {
+    // Read on a core whose TSC is very slightly behind the calibrating core's
+    cycles = 0;
+  }
+  if (static_cast<uint64_t>(cycles) > calibration.recalibration_cycles && // NOLINT(build/unsigned)
+      !m_tsc_calibrating.test_and_set(std::memory_order_acquire)) {
+    calibrate_tsc(&calibration);
+    m_tsc_calibrating.clear(std::memory_order_release);
+  }
+  return calibration.ticks +
+         static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * calibration.ticks_per_cycle) >> 32); // NOLINT
+}
+
+bool
+TimestampEstimatorSystem::get_host_time_for_timestamp(dfmessages::timestamp_t ts, int64_t& steady_time_ns) const
+{
+  // The estimate follows the system time, but waits are timed on the steady time
+  int64_t system_target = static_cast<int64_t>(ticks_to_ns(ts));
+  steady_time_ns = get_clock().steady_time_ns() + (system_target - get_clock().system_time_ns());
+  return true;
 }
 
 } // namespace timinglibs
-} // namespace dunedaq
\ No newline at end of file
+} // namespace dunedaq
@@ -53,6 +53,15 @@ TimingController::init(const nlohmann::json& init_data)
         throw InvalidQueueFatalError(ERS_HERE, get_name(), qi.name, excpt);
       }
     }
+    // optional, only needed to wait for hw cmds to complete
+    if (!qi.name.compare("hardware_command_responses_in")) {
+      try {
+        m_hw_cmd_response_in_queue.reset(new response_source_t(qi.inst));
+        m_hw_cmd_response_queue_name = qi.inst;
+      } catch (const ers::Issue& excpt) {
+        throw InvalidQueueFatalError(ERS_HERE, get_name(), qi.name, excpt);
+      }
+    }
   }
 }
 
@@ -87,6 +96,54 @@ TimingController::send_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd)
   }
 }
 
+timingcmd::TimingHwCmdResponse
+TimingController::send_hw_cmd_and_wait(timingcmd::TimingHwCmd hw_cmd, std::chrono::milliseconds timeout)
+{
+  timingcmd::TimingHwCmdResponse response;
+  response.id = hw_cmd.id;
+  response.device = hw_cmd.device;
+  response.status = timingcmd::TimingHwCmdStatus::timed_out;
+
+  if (!m_hw_cmd_response_in_queue) {
+    throw HardwareCommandResponsesNotConfigured(ERS_HERE, get_name());
+  }
+
+  hw_cmd.correlation_id = ++m_last_correlation_id;
+  hw_cmd.response_queue = m_hw_cmd_response_queue_name;
+  response.correlation_id = hw_cmd.correlation_id;
+  send_hw_cmd(hw_cmd);
+
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (std::chrono::steady_clock::now() < deadline) {
+    timingcmd::TimingHwCmdResponse received;
+    try {
+      m_hw_cmd_response_in_queue->pop(received, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                  deadline - std::chrono::steady_clock::now()));
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired&) {
+      break;
+    }
+    if (received.correlation_id == hw_cmd.correlation_id) {
+      return received;
+    }
+    // a response to an earlier cmd which we stopped waiting for
+    TLOG_DEBUG(0) << get_name() << ": dropping response to hw cmd with correlation id " << received.correlation_id;
+  }
+  return response;
+}
+
+void
+TimingController::send_hw_cmd_batch(const timingcmd::TimingHwCmds& hw_cmds)
+{
+  timingcmd::TimingHwCmdBatchPayload batch_payload;
+  batch_payload.cmds = hw_cmds;
+
+  timingcmd::TimingHwCmd batch_cmd;
+  batch_cmd.id = timingcmd::TimingHwCmdId::batch;
+  timingcmd::to_json(batch_cmd.payload, batch_payload);
+
+  send_hw_cmd(batch_cmd);
+}
+
 } // namespace timinglibs
 } // namespace dunedaq
 
@@ -27,6 +27,7 @@
 #include "ers/Issue.hpp"
 #include "logging/Logging.hpp"
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -101,6 +102,19 @@ protected:
 
   virtual void send_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd);
 
+  // responses to hw cmds, if the hardware_command_responses_in queue is connected
+  using response_source_t = dunedaq::appfwk::DAQSource<timingcmd::TimingHwCmdResponse>;
+  std::unique_ptr<response_source_t> m_hw_cmd_response_in_queue;
+  std::string m_hw_cmd_response_queue_name;
+  timingcmd::CorrelationId m_last_correlation_id{ 0 };
+
+  // send hw_cmd, and wait for the hardware manager to execute it. if there is no response within timeout,
+  // the returned response has status timed_out
+  virtual timingcmd::TimingHwCmdResponse send_hw_cmd_and_wait(timingcmd::TimingHwCmd hw_cmd,
+                                                              std::chrono::milliseconds timeout);
+  // send hw_cmds as one batch, which the hardware manager either executes in order, or rejects as a whole
+  virtual void send_hw_cmd_batch(const timingcmd::TimingHwCmds& hw_cmds);
+
   // opmon
   uint m_number_hw_commands;
   std::vector<AtomicUInt64> m_sent_hw_command_counters;
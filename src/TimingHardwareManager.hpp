@@ -15,6 +15,8 @@
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 
+#include "timinglibs/LogHistogram.hpp"
+#include "timinglibs/StrandPool.hpp"
 #include "timinglibs/TimingIssues.hpp"
 
 #include "InfoGatherer.hpp"
@@ -36,10 +38,18 @@
 
 #include "timing/EndpointNode.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 // NOLINTNEXTLINE(build/define_used)
@@ -105,32 +115,175 @@ protected:
   std::unique_ptr<source_t> m_hw_command_in_queue;
   std::chrono::milliseconds m_queue_timeout;
 
+  // hw cmds for each device are executed in order on the device's strand, while
+  // those for different devices may run concurrently
+  std::unique_ptr<StrandPool> m_hw_cmd_strands;
+  // set at scrap, once no more hw cmds may be posted to the strands
+  std::atomic<bool> m_hw_cmd_strands_stopping{ false };
+
+  // timing hw cmds stuff
+  // handlers may put anything they read back into their second argument, which is returned in the hw cmd response
+  using timing_hw_cmd_handler_t = std::function<void(const timingcmd::TimingHwCmd&, nlohmann::json&)>;
+  // hw cmd handlers of one design, indexed by timingcmd::TimingHwCmdId
+  using timing_hw_cmd_table_t = std::vector<timing_hw_cmd_handler_t>;
+  // hw cmd tables, by design type
+  std::map<std::string, timing_hw_cmd_table_t> m_timing_hw_cmd_map_;
+
+  template<typename Child>
+  void register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
+                                  const std::string& design_type,
+                                  void (Child::*f)(const timingcmd::TimingHwCmd&));
+  template<typename Child>
+  void register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
+                                  const std::string& design_type,
+                                  void (Child::*f)(const timingcmd::TimingHwCmd&, nlohmann::json&));
+  void register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
+                                  const std::string& design_type,
+                                  timing_hw_cmd_handler_t hw_cmd_handler,
+                                  const std::string& handler_type);
+
+  std::string get_hw_cmd_name(timingcmd::TimingHwCmdId hw_cmd_id, const std::string& design_type = "") const;
+
+  // find the handler for hw_cmd. throws if the device or the command is not known
+  const timing_hw_cmd_handler_t& find_hw_cmd_handler(const timingcmd::TimingHwCmd& hw_cmd, std::string& design_type);
+  // called on the strand once a hw cmd has been executed, or dropped, with what its response says
+  using hw_cmd_completion_t =
+    std::function<void(timingcmd::TimingHwCmdStatus, const std::string&, int64_t, const nlohmann::json&)>;
+  // priority overrides the one which hw_cmd would get on its own
+  void post_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd,
+                   const timing_hw_cmd_handler_t& hw_cmd_handler,
+                   const std::string& design_type,
+                   hw_cmd_completion_t on_completion = nullptr,
+                   std::optional<int> priority = std::nullopt);
+
+  // hw cmd priorities: stopping triggers overtakes the cmds waiting for its device, and has a worker of its own,
+  // while diagnostics wait until a device has nothing else to do. the run state cmds, including enabling
+  // triggers, keep their order
+  static constexpr int s_diagnostics_hw_cmd_priority = -1;
+  static constexpr int s_run_state_hw_cmd_priority = 0;
+  static constexpr int s_trigger_stop_hw_cmd_priority = 1;
+  static int get_hw_cmd_priority(timingcmd::TimingHwCmdId hw_cmd_id);
+
+  // a partition_disable_triggers cancels the partition_enable_triggers it overtakes, so that the triggers end up
+  // stopped. counts the partition_disable_triggers cmds posted, by device and partition
+  std::map<std::string, uint64_t> m_trigger_stop_counts; // NOLINT(build/unsigned)
+  std::mutex m_trigger_stop_counts_mutex;
+  uint64_t count_trigger_stops(const timingcmd::TimingHwCmd& hw_cmd, bool increment); // NOLINT(build/unsigned)
+  // a batch is accepted only if all of its cmds are valid. its cmds all get the priority of the most urgent one, so
+  // that they still run in the order of the batch
+  void process_hw_cmd_batch(const timingcmd::TimingHwCmd& batch_cmd);
+  // the batch cmd itself is answered once all of its cmds are done, with the response of each of them. cmds for
+  // different devices complete on different strands, hence the mutex
+  struct HwCmdBatchRun
+  {
+    timingcmd::TimingHwCmd batch_cmd;
+    timingcmd::TimingHwCmds cmds;
+    std::vector<timingcmd::TimingHwCmdResponse> cmd_responses;
+    size_t n_completed = 0;
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point start;
+  };
+  void complete_hw_cmd_batch_cmd(std::shared_ptr<HwCmdBatchRun> run,
+                                 size_t index,
+                                 timingcmd::TimingHwCmdStatus status,
+                                 const std::string& message,
+                                 int64_t execution_time_us,
+                                 const nlohmann::json& result);
+
+  // named hw cmd sequences from the configuration. a sequence runs one cmd at a time, and stops at the first which
+  // does not succeed
+  std::map<std::string, timingcmd::TimingHwCmds> m_hw_cmd_sequences;
+  void set_hw_cmd_sequences(const nlohmann::json& hw_cmd_sequences);
+
+  struct HwCmdSequenceRun
+  {
+    timingcmd::TimingHwCmd sequence_cmd;
+    std::string sequence_name;
+    std::vector<std::tuple<timingcmd::TimingHwCmd, const timing_hw_cmd_handler_t*, std::string>> steps;
+    nlohmann::json step_responses = nlohmann::json::array();
+    std::chrono::steady_clock::time_point start;
+  };
+  void process_hw_cmd_sequence(const timingcmd::TimingHwCmd& sequence_cmd);
+  void post_hw_cmd_sequence_step(std::shared_ptr<HwCmdSequenceRun> run);
+  void complete_hw_cmd_sequence_step(std::shared_ptr<HwCmdSequenceRun> run,
+                                     timingcmd::TimingHwCmdStatus status,
+                                     const std::string& message,
+                                     int64_t execution_time_us,
+                                     const nlohmann::json& result);
+
+  // hw cmd responses, sent only for hw cmds which name a response queue
+  using response_sink_t = dunedaq::appfwk::DAQSink<timingcmd::TimingHwCmdResponse>;
+  std::map<std::string, std::shared_ptr<response_sink_t>> m_hw_cmd_response_sinks;
+  std::mutex m_hw_cmd_response_sinks_mutex;
+  // responses which don't fit into their queue straight away are dropped, and counted
+  static constexpr std::chrono::milliseconds s_hw_cmd_response_timeout{ 0 };
+
+  void respond_to_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd,
+                         timingcmd::TimingHwCmdStatus status,
+                         const std::string& message = "",
+                         int64_t execution_time_us = 0,
+                         nlohmann::json result = nlohmann::json());
+
   // uhal members
   std::string m_connections_file;
   std::unique_ptr<uhal::ConnectionManager> m_connection_manager;
-  std::map<std::string, std::unique_ptr<uhal::HwInterface>> m_hw_device_map;
-  std::mutex m_hw_device_map_mutex;
 
-  void construct_hw_cmd_name(const timingcmd::TimingHwCmd& hw_cmd, std::string& hw_cmd_name);
+  // a timing device, with its design type resolved when its hw interface is created
+  struct HwDevice
+  {
+    std::unique_ptr<uhal::HwInterface> hw_interface;
+    std::string design_type;
+    const timing_hw_cmd_table_t* hw_cmds; // nullptr if no commands are registered for the design
+  };
+  std::shared_ptr<HwDevice> create_hw_device(const std::string& device_name) const;
+
+  // the timing devices. a registry is never modified once published, so looking a device up only loads the pointer
+  // to the current registry, without taking any lock. a device which was not warmed up is added by publishing a new
+  // registry, which keeps the devices of the old one. every registry published is kept until clear_hw_devices(), so
+  // a lookup never sees one being freed
+  using hw_device_registry_t = std::map<std::string, std::shared_ptr<const HwDevice>>;
+  std::atomic<const hw_device_registry_t*> m_hw_device_registry{ nullptr };
+  std::vector<std::unique_ptr<const hw_device_registry_t>> m_hw_device_registries;
+  std::mutex m_hw_device_registry_update_mutex;
+  // publish a registry. the caller holds m_hw_device_registry_update_mutex
+  void publish_hw_device_registry(std::unique_ptr<const hw_device_registry_t> hw_device_registry);
+
+  // retrieve a timing device, creating its hw interface if needed
+  const HwDevice& get_hw_device(const std::string& device_name);
+
+  // create the hw interfaces of the devices, in parallel, and check that they respond
+  void warm_up_hw_devices(const std::vector<std::string>& device_names);
+  // read one register of the device, its version register if the design has one, and wait for the answer
+  void read_hw_device_register(const std::string& device_name, uhal::HwInterface& hw_interface) const;
+
+  // forget the timing devices, e.g. when the connections file changes. there must be no users of the devices left
+  void clear_hw_devices();
+
+  // the configurations last written by partition_configure, endpoint_enable and hsi_configure, by device and by what
+  // they configure, so that writing the same again can be skipped. a configuration whose write failed, or may have
+  // been undone, is forgotten
+  std::map<std::string, std::map<std::string, nlohmann::json>> m_hw_config_shadows;
+  std::mutex m_hw_config_shadows_mutex;
+
+  bool is_hw_config_applied(const std::string& device_name, const std::string& target, const nlohmann::json& config);
+  void set_hw_config_applied(const std::string& device_name, const std::string& target, const nlohmann::json& config);
+  // forget the configurations of a target of a device, or of the whole device if no target is given
+  void invalidate_hw_config(const std::string& device_name, const std::string& target = "");
+  // what a partition's configuration is remembered under
+  static std::string get_partition_config_target(uint32_t partition_id); // NOLINT(build/unsigned)
+  // forget the configuration of a partition, whose state a cmd other than partition_configure changes
+  void invalidate_partition_config(const std::string& device_name, uint32_t partition_id); // NOLINT(build/unsigned)
 
   // retrieve top level/design object for a timing device
   template<class TIMING_DEV>
   const TIMING_DEV& get_timing_device(const std::string& device_name);
 
-  // timing hw cmds stuff
-  std::map<timingcmd::TimingHwCmdId, std::function<void(const timingcmd::TimingHwCmd&)>> m_timing_hw_cmd_map_;
-
-  template<typename Child>
-  void register_timing_hw_command(const std::string& hw_cmd_id,
-                                  const std::string& design_type,
-                                  void (Child::*f)(const timingcmd::TimingHwCmd&));
-
   // timing common commands
   template<class DSGN>
   void io_reset(const timingcmd::TimingHwCmd& hw_cmd);
 
   template<class DSGN>
-  void print_status(const timingcmd::TimingHwCmd& hw_cmd);
+  void print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
 
   // timing master commands
   template<class DSGN>
@@ -138,7 +291,7 @@ protected:
 
   // timing partition commands
   template<class DSGN>
-  void partition_configure(const timingcmd::TimingHwCmd& hw_cmd);
+  void partition_configure(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
   template<class DSGN>
   void partition_enable(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
@@ -152,33 +305,51 @@ protected:
   template<class DSGN>
   void partition_disable_triggers(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
-  void partition_print_status(const timingcmd::TimingHwCmd& hw_cmd);
+  void partition_print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
 
   // timing endpoint commands
   template<class DSGN>
-  void endpoint_enable(const timingcmd::TimingHwCmd& hw_cmd);
+  void endpoint_enable(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
   template<class DSGN>
   void endpoint_disable(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
   void endpoint_reset(const timingcmd::TimingHwCmd& hw_cmd);
+  template<class DSGN>
+  void endpoint_print_timestamp(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
 
   // hsi
   template<class DSGN>
   void hsi_reset(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
-  void hsi_configure(const timingcmd::TimingHwCmd& hw_cmd);
+  void hsi_configure(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
   template<class DSGN>
   void hsi_start(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
   void hsi_stop(const timingcmd::TimingHwCmd& hw_cmd);
   template<class DSGN>
-  void hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd);
+  void hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result);
 
   // opmon stuff
-  std::atomic<uint64_t> m_received_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_accepted_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_rejected_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_failed_hw_commands_counter;   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_received_hw_commands_counter;     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_accepted_hw_commands_counter;     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_rejected_hw_commands_counter;     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_failed_hw_commands_counter;       // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_skipped_hw_commands_counter;      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_dropped_hw_cmd_responses_counter; // NOLINT(build/unsigned)
+
+  // time from posting to starting, and executing, the hw cmds which were executed [us], by cmd and device
+  struct HwCmdLatencies
+  {
+    LogHistogram queue_wait;
+    LogHistogram execution;
+  };
+  std::map<std::pair<timingcmd::TimingHwCmdId, std::string>, HwCmdLatencies> m_hw_cmd_latencies;
+  std::mutex m_hw_cmd_latencies_mutex;
+
+  void record_hw_cmd_latencies(const timingcmd::TimingHwCmd& hw_cmd,
+                               std::chrono::steady_clock::duration queue_wait,
+                               std::chrono::steady_clock::duration execution);
+  void reset_hw_cmd_latencies();
 
   // monitoring
   std::map<std::string, std::unique_ptr<InfoGathererInterface>> m_info_gatherers;
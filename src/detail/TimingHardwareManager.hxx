@@ -10,6 +10,8 @@ TimingHardwareManager::TimingHardwareManager(const std::string& name)
   , m_accepted_hw_commands_counter{ 0 }
   , m_rejected_hw_commands_counter{ 0 }
   , m_failed_hw_commands_counter{ 0 }
+  , m_skipped_hw_commands_counter{ 0 }
+  , m_dropped_hw_cmd_responses_counter{ 0 }
 {
   // all hardware manager variants will need these commands
   register_command("start", &TimingHardwareManager::do_start);
@@ -40,6 +42,9 @@ TimingHardwareManager::do_start(const nlohmann::json&)
   m_accepted_hw_commands_counter = 0;
   m_rejected_hw_commands_counter = 0;
   m_failed_hw_commands_counter = 0;
+  m_skipped_hw_commands_counter = 0;
+  m_dropped_hw_cmd_responses_counter = 0;
+  reset_hw_cmd_latencies();
   TLOG() << get_name() << " successfully started";
 }
 
@@ -54,11 +59,24 @@ TimingHardwareManager::do_scrap(const nlohmann::json&)
 {
   // TODO other scraping stuff
   thread_.stop_working_thread();
+  // let the hw cmds which were already accepted finish. the steps of running sequences which are still to be posted
+  // are rejected from now on, so the strands do drain
+  m_hw_cmd_strands_stopping = true;
+  if (m_hw_cmd_strands) {
+    m_hw_cmd_strands->wait_idle();
+  }
+  m_hw_cmd_strands.reset();
   stop_hw_mon_gathering();
+  clear_hw_devices();
   m_received_hw_commands_counter = 0;
   m_accepted_hw_commands_counter = 0;
   m_rejected_hw_commands_counter = 0;
   m_failed_hw_commands_counter = 0;
+  m_skipped_hw_commands_counter = 0;
+  m_dropped_hw_cmd_responses_counter = 0;
+  // get_info may be reading the latencies at the same time
+  std::lock_guard<std::mutex> lk(m_hw_cmd_latencies_mutex);
+  m_hw_cmd_latencies.clear();
 }
 
 template<class INFO, class DSGN>
@@ -66,15 +84,9 @@ void
 TimingHardwareManager::register_info_gatherer(uint gather_interval, const std::string& device_name, int op_mon_level)
 {
 
-  try {
-    if (typeid(const DSGN&) != typeid(m_connection_manager->getDevice(device_name).getNode(""))) {
-      TLOG_DEBUG(0) << device_name << " is not of type " << typeid(DSGN).name() << ". I will not monitor the hw";
-      return;
-    }
-  } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
-    std::stringstream message;
-    message << "UHAL device name not " << device_name << " in connections file";
-    throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
+  if (get_hw_device(device_name).design_type != typeid(DSGN).name()) {
+    TLOG_DEBUG(0) << device_name << " is not of type " << typeid(DSGN).name() << ". I will not monitor the hw";
+    return;
   }
 
   std::unique_ptr<InfoGathererInterface> gatherer = std::make_unique<InfoGatherer<INFO>>(
@@ -99,7 +111,7 @@ TimingHardwareManager::gather_monitor_data(InfoGatherer<INFO>& gatherer)
 
     // collect the data from the hardware
     try {
-      auto design = get_timing_device<DSGN>(device_name);
+      const auto& design = get_timing_device<DSGN>(device_name);
       design.get_info(mon_data);
 
       // when did we actually collect the data
@@ -127,13 +139,17 @@ TimingHardwareManager::start_hw_mon_gathering(const std::string& device_name)
     for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it)
       it->second.get()->start_gathering_thread();
   } else {
-    // find gatherer for suppled device name and start it
-    bool gatherer_found=false;
-    for (auto it = m_info_gatherers.lower_bound(device_name); it != m_info_gatherers.end(); ++it) {
+    // find the gatherers for the supplied device name and start them. a device name may be the start of another's,
+    // so the names of the gatherers can't be used to find them
+    bool gatherer_found = false;
+    for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it) {
+      if (it->second->get_device_name() != device_name) {
+        continue;
+      }
       TLOG_DEBUG(0) << get_name() << " Starting info gatherer: " << it->first;
       it->second.get()->start_gathering_thread();
-      gatherer_found=true;
-    } 
+      gatherer_found = true;
+    }
     if (!gatherer_found) ers::error(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "start", device_name));
   }
 }
@@ -147,24 +163,32 @@ TimingHardwareManager::stop_hw_mon_gathering(const std::string& device_name)
     for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it)
       it->second.get()->stop_gathering_thread();
   } else {
-    // find gatherer for suppled device name and stop it
-    bool gatherer_found=false;
-    for (auto it = m_info_gatherers.lower_bound(device_name); it != m_info_gatherers.end(); ++it) {
+    // find the gatherers for the supplied device name and stop them. a device name may be the start of another's,
+    // so the names of the gatherers can't be used to find them
+    bool gatherer_found = false;
+    for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it) {
+      if (it->second->get_device_name() != device_name) {
+        continue;
+      }
       TLOG_DEBUG(0) << get_name() << " Stopping info gatherer: " << it->first;
       it->second.get()->stop_gathering_thread();
-      gatherer_found=true;
-    } 
+      gatherer_found = true;
+    }
     if (!gatherer_found) ers::error(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "stop", device_name));
   }
 }
 
 // cmd stuff
 
-void
-TimingHardwareManager::construct_hw_cmd_name(const timingcmd::TimingHwCmd& hw_cmd, std::string& hw_cmd_name)
+std::string
+TimingHardwareManager::get_hw_cmd_name(timingcmd::TimingHwCmdId hw_cmd_id, const std::string& design_type) const
 {
-  hw_cmd_name = hw_cmd.id + "_" + typeid(m_connection_manager->getDevice(hw_cmd.device).getNode()).name();
-  TLOG_DEBUG(0) << get_name() << ": constructed hw cmd name: " << hw_cmd_name;
+  nlohmann::json hw_cmd_id_json;
+  timingcmd::to_json(hw_cmd_id_json, hw_cmd_id);
+  if (design_type.empty()) {
+    return hw_cmd_id_json.get<std::string>();
+  }
+  return hw_cmd_id_json.get<std::string>() + "_" + design_type;
 }
 
 void
@@ -186,34 +210,30 @@ TimingHardwareManager::process_hardware_commands(std::atomic<bool>& running_flag
       continue;
     }
 
+    if (timing_hw_cmd.id == timingcmd::TimingHwCmdId::batch) {
+      process_hw_cmd_batch(timing_hw_cmd);
+      continue;
+    }
+    if (timing_hw_cmd.id == timingcmd::TimingHwCmdId::sequence) {
+      process_hw_cmd_sequence(timing_hw_cmd);
+      continue;
+    }
+
     ++m_received_hw_commands_counter;
 
     TLOG_DEBUG(0) << get_name() << ": Received hardware command #" << m_received_hw_commands_counter.load()
-                  << ", it is of type: " << timing_hw_cmd.id << ", targeting device: " << timing_hw_cmd.device;
+                  << ", it is of type: " << get_hw_cmd_name(timing_hw_cmd.id)
+                  << ", targeting device: " << timing_hw_cmd.device;
 
-    std::string hw_cmd_name;
+    std::string design_type;
     try {
-      construct_hw_cmd_name(timing_hw_cmd, hw_cmd_name);
-    } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
-      std::stringstream message;
-      message << "UHAL device name not " << timing_hw_cmd.device << " in connections file";
-      throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
-    }
-
-    if (auto cmd = m_timing_hw_cmd_map_.find(hw_cmd_name); cmd != m_timing_hw_cmd_map_.end()) {
-
+      const auto& hw_cmd_handler = find_hw_cmd_handler(timing_hw_cmd, design_type);
       ++m_accepted_hw_commands_counter;
-
-      TLOG_DEBUG(0) << "Found hw cmd: " << hw_cmd_name;
-      try {
-        std::invoke(cmd->second, timing_hw_cmd);
-      } catch (const std::exception& exception) {
-        ers::error(FailedToExecuteHardwareCommand(ERS_HERE, hw_cmd_name, timing_hw_cmd.device, exception));
-        ++m_failed_hw_commands_counter;
-      }
-    } else {
-      ers::error(InvalidHardwareCommandID(ERS_HERE, hw_cmd_name));
+      post_hw_cmd(timing_hw_cmd, hw_cmd_handler, design_type);
+    } catch (const ers::Issue& excpt) {
+      ers::error(excpt);
       ++m_rejected_hw_commands_counter;
+      respond_to_hw_cmd(timing_hw_cmd, timingcmd::TimingHwCmdStatus::rejected, excpt.what());
     }
   }
 
@@ -223,58 +243,692 @@ TimingHardwareManager::process_hardware_commands(std::atomic<bool>& running_flag
   TLOG_DEBUG(0) << get_name() << exiting_stream.str();
 }
 
+const TimingHardwareManager::timing_hw_cmd_handler_t&
+TimingHardwareManager::find_hw_cmd_handler(const timingcmd::TimingHwCmd& hw_cmd, std::string& design_type)
+{
+  const auto& hw_device = get_hw_device(hw_cmd.device);
+  design_type = hw_device.design_type;
+
+  // the design of the device was resolved once, so finding the command is just an index into its table
+  auto cmd_index = static_cast<size_t>(hw_cmd.id);
+  if (hw_device.hw_cmds == nullptr || cmd_index >= hw_device.hw_cmds->size() || !hw_device.hw_cmds->at(cmd_index)) {
+    throw InvalidHardwareCommandID(ERS_HERE, get_hw_cmd_name(hw_cmd.id, design_type));
+  }
+
+  TLOG_DEBUG(0) << "Found hw cmd: " << get_hw_cmd_name(hw_cmd.id, design_type);
+  return hw_device.hw_cmds->at(cmd_index);
+}
+
+void
+TimingHardwareManager::post_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd,
+                                   const timing_hw_cmd_handler_t& hw_cmd_handler,
+                                   const std::string& design_type,
+                                   hw_cmd_completion_t on_completion,
+                                   std::optional<int> priority)
+{
+  if (m_hw_cmd_strands_stopping) {
+    TLOG() << get_name() << ": Not executing " << get_hw_cmd_name(hw_cmd.id, design_type) << " for "
+           << hw_cmd.device << ", as the hw cmd workers are stopping";
+    ++m_rejected_hw_commands_counter;
+    std::string message = "hw cmd workers are stopping";
+    if (on_completion) {
+      on_completion(timingcmd::TimingHwCmdStatus::rejected, message, 0, nlohmann::json());
+    }
+    respond_to_hw_cmd(hw_cmd, timingcmd::TimingHwCmdStatus::rejected, message);
+    return;
+  }
+
+  if (!priority) {
+    priority = get_hw_cmd_priority(hw_cmd.id);
+  }
+
+  // the number of trigger stops for the partition which an enable must still see when it runs
+  uint64_t trigger_stops = 0; // NOLINT(build/unsigned)
+  if (hw_cmd.id == timingcmd::TimingHwCmdId::partition_disable_triggers) {
+    count_trigger_stops(hw_cmd, true);
+  } else if (hw_cmd.id == timingcmd::TimingHwCmdId::partition_enable_triggers) {
+    trigger_stops = count_trigger_stops(hw_cmd, false);
+  }
+
+  auto posted = std::chrono::steady_clock::now();
+
+  // the handlers live as long as this module, so they can be referred to from the strand
+  auto task = [this, &hw_cmd_handler, hw_cmd, design_type, trigger_stops, posted, on_completion]() {
+    auto complete = [&](timingcmd::TimingHwCmdStatus status,
+                        const std::string& message,
+                        int64_t execution_time_us,
+                        nlohmann::json result) {
+      if (on_completion) {
+        on_completion(status, message, execution_time_us, result);
+      }
+      respond_to_hw_cmd(hw_cmd, status, message, execution_time_us, std::move(result));
+    };
+
+    if (hw_cmd.id == timingcmd::TimingHwCmdId::partition_enable_triggers &&
+        count_trigger_stops(hw_cmd, false) != trigger_stops) {
+      TLOG() << get_name() << ": Dropping " << get_hw_cmd_name(hw_cmd.id, design_type) << " for " << hw_cmd.device
+             << ", as a later partition_disable_triggers overtook it";
+      complete(timingcmd::TimingHwCmdStatus::rejected, "overtaken by partition_disable_triggers", 0, nlohmann::json());
+      return;
+    }
+
+    nlohmann::json result;
+    auto execution_start = std::chrono::steady_clock::now();
+    try {
+      std::invoke(hw_cmd_handler, hw_cmd, result);
+    } catch (const std::exception& exception) {
+      FailedToExecuteHardwareCommand failure(
+        ERS_HERE, get_hw_cmd_name(hw_cmd.id, design_type), hw_cmd.device, exception);
+      ers::error(failure);
+      ++m_failed_hw_commands_counter;
+      auto execution_time = std::chrono::steady_clock::now() - execution_start;
+      record_hw_cmd_latencies(hw_cmd, execution_start - posted, execution_time);
+      complete(timingcmd::TimingHwCmdStatus::failed,
+               failure.what(),
+               std::chrono::duration_cast<std::chrono::microseconds>(execution_time).count(),
+               nlohmann::json());
+      return;
+    }
+    auto execution_time = std::chrono::steady_clock::now() - execution_start;
+    record_hw_cmd_latencies(hw_cmd, execution_start - posted, execution_time);
+    complete(timingcmd::TimingHwCmdStatus::ok,
+             "",
+             std::chrono::duration_cast<std::chrono::microseconds>(execution_time).count(),
+             std::move(result));
+  };
+  m_hw_cmd_strands->post(hw_cmd.device, std::move(task), *priority);
+}
+
+void
+TimingHardwareManager::record_hw_cmd_latencies(const timingcmd::TimingHwCmd& hw_cmd,
+                                               std::chrono::steady_clock::duration queue_wait,
+                                               std::chrono::steady_clock::duration execution)
+{
+  std::lock_guard<std::mutex> lk(m_hw_cmd_latencies_mutex);
+  auto& latencies = m_hw_cmd_latencies[std::make_pair(hw_cmd.id, hw_cmd.device)];
+  latencies.queue_wait.record(std::chrono::duration_cast<std::chrono::microseconds>(queue_wait).count());
+  latencies.execution.record(std::chrono::duration_cast<std::chrono::microseconds>(execution).count());
+}
+
+void
+TimingHardwareManager::reset_hw_cmd_latencies()
+{
+  std::lock_guard<std::mutex> lk(m_hw_cmd_latencies_mutex);
+  // hw cmds may still be running, so keep the histograms and only empty them
+  for (auto& [cmd_and_device, latencies] : m_hw_cmd_latencies) {
+    latencies.queue_wait.reset();
+    latencies.execution.reset();
+  }
+}
+
+int
+TimingHardwareManager::get_hw_cmd_priority(timingcmd::TimingHwCmdId hw_cmd_id)
+{
+  switch (hw_cmd_id) {
+    case timingcmd::TimingHwCmdId::partition_disable_triggers:
+      return s_trigger_stop_hw_cmd_priority;
+    case timingcmd::TimingHwCmdId::print_status:
+    case timingcmd::TimingHwCmdId::partition_print_status:
+    case timingcmd::TimingHwCmdId::endpoint_print_timestamp:
+    case timingcmd::TimingHwCmdId::hsi_print_status:
+      return s_diagnostics_hw_cmd_priority;
+    default:
+      return s_run_state_hw_cmd_priority;
+  }
+}
+
+uint64_t // NOLINT(build/unsigned)
+TimingHardwareManager::count_trigger_stops(const timingcmd::TimingHwCmd& hw_cmd, bool increment)
+{
+  // a bad payload is left for the handler to complain about
+  timingcmd::TimingPartitionCmdPayload cmd_payload;
+  try {
+    timingcmd::from_json(hw_cmd.payload, cmd_payload);
+  } catch (const std::exception&) {
+    return 0;
+  }
+  auto partition_key = hw_cmd.device + "/" + std::to_string(cmd_payload.partition_id);
+
+  std::lock_guard<std::mutex> lk(m_trigger_stop_counts_mutex);
+  auto& trigger_stops = m_trigger_stop_counts[partition_key];
+  if (increment) {
+    ++trigger_stops;
+  }
+  return trigger_stops;
+}
+
+void
+TimingHardwareManager::process_hw_cmd_batch(const timingcmd::TimingHwCmd& batch_cmd)
+{
+  timingcmd::TimingHwCmdBatchPayload batch_payload;
+  try {
+    timingcmd::from_json(batch_cmd.payload, batch_payload);
+  } catch (const std::exception& excpt) {
+    InvalidHardwareCommandID invalid_batch(ERS_HERE, get_hw_cmd_name(batch_cmd.id), excpt);
+    ers::error(invalid_batch);
+    ++m_received_hw_commands_counter;
+    ++m_rejected_hw_commands_counter;
+    respond_to_hw_cmd(batch_cmd, timingcmd::TimingHwCmdStatus::rejected, invalid_batch.what());
+    return;
+  }
+  auto n_cmds = batch_payload.cmds.size();
+  m_received_hw_commands_counter += n_cmds;
+
+  TLOG_DEBUG(0) << get_name() << ": Received batch of " << n_cmds << " hardware commands";
+
+  // check the whole batch before executing any of it, so that a bad cmd can't leave it half done
+  std::vector<std::pair<const timing_hw_cmd_handler_t*, std::string>> hw_cmd_handlers;
+  try {
+    for (auto& hw_cmd : batch_payload.cmds) {
+      std::string design_type;
+      const auto& hw_cmd_handler = find_hw_cmd_handler(hw_cmd, design_type);
+      hw_cmd_handlers.emplace_back(&hw_cmd_handler, design_type);
+    }
+  } catch (const ers::Issue& excpt) {
+    ers::error(excpt);
+    m_rejected_hw_commands_counter += n_cmds;
+    for (auto& hw_cmd : batch_payload.cmds) {
+      respond_to_hw_cmd(hw_cmd, timingcmd::TimingHwCmdStatus::rejected, excpt.what());
+    }
+    respond_to_hw_cmd(batch_cmd, timingcmd::TimingHwCmdStatus::rejected, excpt.what());
+    return;
+  }
+
+  // no other cmds are posted in between, and they all have the same priority, so the cmds of the batch for each
+  // device run back to back, in order
+  int batch_priority = s_diagnostics_hw_cmd_priority;
+  for (auto& hw_cmd : batch_payload.cmds) {
+    batch_priority = std::max(batch_priority, get_hw_cmd_priority(hw_cmd.id));
+  }
+  m_accepted_hw_commands_counter += n_cmds;
+
+  // only a batch which names a response queue needs to follow its cmds
+  std::shared_ptr<HwCmdBatchRun> run;
+  if (!batch_cmd.response_queue.empty()) {
+    if (n_cmds == 0) {
+      nlohmann::json result = { { "cmds", nlohmann::json::array() } };
+      respond_to_hw_cmd(batch_cmd, timingcmd::TimingHwCmdStatus::ok, "", 0, std::move(result));
+      return;
+    }
+    run = std::make_shared<HwCmdBatchRun>();
+    run->batch_cmd = batch_cmd;
+    run->cmds = batch_payload.cmds;
+    run->cmd_responses.resize(n_cmds);
+    run->start = std::chrono::steady_clock::now();
+  }
+  for (size_t i = 0; i < n_cmds; ++i) {
+    hw_cmd_completion_t on_completion;
+    if (run) {
+      on_completion = std::bind(&TimingHardwareManager::complete_hw_cmd_batch_cmd,
+                                this,
+                                run,
+                                i,
+                                std::placeholders::_1,
+                                std::placeholders::_2,
+                                std::placeholders::_3,
+                                std::placeholders::_4);
+    }
+    post_hw_cmd(batch_payload.cmds.at(i),
+                *hw_cmd_handlers.at(i).first,
+                hw_cmd_handlers.at(i).second,
+                std::move(on_completion),
+                batch_priority);
+  }
+}
+
+void
+TimingHardwareManager::complete_hw_cmd_batch_cmd(std::shared_ptr<HwCmdBatchRun> run,
+                                                 size_t index,
+                                                 timingcmd::TimingHwCmdStatus status,
+                                                 const std::string& message,
+                                                 int64_t execution_time_us,
+                                                 const nlohmann::json& result)
+{
+  const auto& hw_cmd = run->cmds.at(index);
+
+  std::lock_guard<std::mutex> lk(run->mutex);
+  auto& cmd_response = run->cmd_responses.at(index);
+  cmd_response.id = hw_cmd.id;
+  cmd_response.device = hw_cmd.device;
+  cmd_response.status = status;
+  cmd_response.execution_time_us = execution_time_us;
+  cmd_response.message = message;
+  cmd_response.result = result;
+  if (++run->n_completed < run->cmd_responses.size()) {
+    return;
+  }
+
+  // the batch gets the status of its first cmd which did not succeed
+  auto batch_status = timingcmd::TimingHwCmdStatus::ok;
+  std::string batch_message;
+  nlohmann::json cmd_responses = nlohmann::json::array();
+  for (size_t i = 0; i < run->cmd_responses.size(); ++i) {
+    const auto& response = run->cmd_responses.at(i);
+    if (response.status != timingcmd::TimingHwCmdStatus::ok && batch_status == timingcmd::TimingHwCmdStatus::ok) {
+      std::ostringstream failure;
+      failure << "cmd " << i << ", " << get_hw_cmd_name(response.id) << " on " << response.device
+              << ", did not succeed: " << response.message;
+      batch_status = response.status;
+      batch_message = failure.str();
+    }
+    nlohmann::json response_json;
+    timingcmd::to_json(response_json, response);
+    cmd_responses.push_back(std::move(response_json));
+  }
+
+  auto batch_time_us =
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run->start).count();
+  nlohmann::json batch_result = { { "cmds", std::move(cmd_responses) } };
+  respond_to_hw_cmd(run->batch_cmd, batch_status, batch_message, batch_time_us, std::move(batch_result));
+}
+
+void
+TimingHardwareManager::set_hw_cmd_sequences(const nlohmann::json& hw_cmd_sequences)
+{
+  m_hw_cmd_sequences.clear();
+  if (hw_cmd_sequences.is_null()) {
+    return;
+  }
+
+  for (auto& sequence : hw_cmd_sequences.get<timingcmd::TimingHwCmdSequences>()) {
+    if (!m_hw_cmd_sequences.emplace(sequence.name, sequence.cmds).second) {
+      throw DuplicateHardwareCommandSequence(ERS_HERE, sequence.name);
+    }
+    TLOG_DEBUG(0) << get_name() << ": hw cmd sequence " << sequence.name << " has " << sequence.cmds.size()
+                  << " cmds";
+  }
+}
+
+void
+TimingHardwareManager::process_hw_cmd_sequence(const timingcmd::TimingHwCmd& sequence_cmd)
+{
+  ++m_received_hw_commands_counter;
+
+  auto run = std::make_shared<HwCmdSequenceRun>();
+  run->sequence_cmd = sequence_cmd;
+  try {
+    timingcmd::TimingHwCmdSequencePayload sequence_payload;
+    try {
+      timingcmd::from_json(sequence_cmd.payload, sequence_payload);
+    } catch (const std::exception& excpt) {
+      throw InvalidHardwareCommandID(ERS_HERE, get_hw_cmd_name(sequence_cmd.id), excpt);
+    }
+    run->sequence_name = sequence_payload.name;
+
+    auto sequence = m_hw_cmd_sequences.find(run->sequence_name);
+    if (sequence == m_hw_cmd_sequences.end()) {
+      throw UnknownHardwareCommandSequence(ERS_HERE, get_hw_cmd_name(sequence_cmd.id), run->sequence_name);
+    }
+
+    // as for batches, check every cmd before executing any of them
+    for (auto& hw_cmd : sequence->second) {
+      std::string design_type;
+      const auto& hw_cmd_handler = find_hw_cmd_handler(hw_cmd, design_type);
+      run->steps.emplace_back(hw_cmd, &hw_cmd_handler, design_type);
+    }
+  } catch (const ers::Issue& excpt) {
+    ers::error(excpt);
+    ++m_rejected_hw_commands_counter;
+    respond_to_hw_cmd(sequence_cmd, timingcmd::TimingHwCmdStatus::rejected, excpt.what());
+    return;
+  }
+
+  ++m_accepted_hw_commands_counter;
+  TLOG_DEBUG(0) << get_name() << ": Running hw cmd sequence " << run->sequence_name << " of " << run->steps.size()
+                << " cmds";
+  run->start = std::chrono::steady_clock::now();
+  post_hw_cmd_sequence_step(std::move(run));
+}
+
+void
+TimingHardwareManager::post_hw_cmd_sequence_step(std::shared_ptr<HwCmdSequenceRun> run)
+{
+  auto step = run->step_responses.size();
+  if (step == run->steps.size()) {
+    auto execution_time_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run->start).count();
+    nlohmann::json result = { { "sequence", run->sequence_name }, { "steps", run->step_responses } };
+    TLOG_DEBUG(0) << get_name() << ": hw cmd sequence " << run->sequence_name << " done in " << execution_time_us
+                  << " us";
+    respond_to_hw_cmd(run->sequence_cmd, timingcmd::TimingHwCmdStatus::ok, "", execution_time_us, std::move(result));
+    return;
+  }
+
+  // each cmd is posted only when the one before it is done, as they may be for different devices
+  const auto& [hw_cmd, hw_cmd_handler, design_type] = run->steps.at(step);
+  post_hw_cmd(hw_cmd, *hw_cmd_handler, design_type, std::bind(&TimingHardwareManager::complete_hw_cmd_sequence_step,
+                                                              this,
+                                                              run,
+                                                              std::placeholders::_1,
+                                                              std::placeholders::_2,
+                                                              std::placeholders::_3,
+                                                              std::placeholders::_4));
+}
+
+void
+TimingHardwareManager::complete_hw_cmd_sequence_step(std::shared_ptr<HwCmdSequenceRun> run,
+                                                     timingcmd::TimingHwCmdStatus status,
+                                                     const std::string& message,
+                                                     int64_t execution_time_us,
+                                                     const nlohmann::json& result)
+{
+  auto step = run->step_responses.size();
+  const auto& hw_cmd = std::get<0>(run->steps.at(step));
+
+  timingcmd::TimingHwCmdResponse step_response;
+  step_response.id = hw_cmd.id;
+  step_response.device = hw_cmd.device;
+  step_response.status = status;
+  step_response.execution_time_us = execution_time_us;
+  step_response.message = message;
+  step_response.result = result;
+  nlohmann::json step_response_json;
+  timingcmd::to_json(step_response_json, step_response);
+  run->step_responses.push_back(std::move(step_response_json));
+
+  if (status == timingcmd::TimingHwCmdStatus::ok) {
+    post_hw_cmd_sequence_step(std::move(run));
+    return;
+  }
+
+  std::ostringstream failure;
+  failure << "step " << step << ", " << get_hw_cmd_name(hw_cmd.id) << " on " << hw_cmd.device
+          << ", did not succeed: " << message;
+  TLOG() << get_name() << ": hw cmd sequence " << run->sequence_name << " stopped at " << failure.str();
+
+  auto sequence_time_us =
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run->start).count();
+  nlohmann::json sequence_result = { { "sequence", run->sequence_name }, { "steps", run->step_responses } };
+  respond_to_hw_cmd(run->sequence_cmd, status, failure.str(), sequence_time_us, std::move(sequence_result));
+}
+
+void
+TimingHardwareManager::respond_to_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd,
+                                         timingcmd::TimingHwCmdStatus status,
+                                         const std::string& message,
+                                         int64_t execution_time_us,
+                                         nlohmann::json result)
+{
+  if (hw_cmd.response_queue.empty()) {
+    return;
+  }
+
+  timingcmd::TimingHwCmdResponse response;
+  response.correlation_id = hw_cmd.correlation_id;
+  response.id = hw_cmd.id;
+  response.device = hw_cmd.device;
+  response.status = status;
+  response.message = message;
+  response.execution_time_us = execution_time_us;
+  response.result = std::move(result);
+
+  // responses are sent from all the strands, and the sinks are created when first used. the lock only covers
+  // finding the sink, so that a full response queue can't hold up the strands of other devices
+  std::shared_ptr<response_sink_t> response_sink;
+  try {
+    std::lock_guard<std::mutex> response_sinks_guard(m_hw_cmd_response_sinks_mutex);
+    auto& sink = m_hw_cmd_response_sinks[hw_cmd.response_queue];
+    if (!sink) {
+      sink = std::make_shared<response_sink_t>(hw_cmd.response_queue);
+    }
+    response_sink = sink;
+  } catch (const ers::Issue& excpt) {
+    ers::error(InvalidQueueFatalError(ERS_HERE, get_name(), hw_cmd.response_queue, excpt));
+    ++m_dropped_hw_cmd_responses_counter;
+    std::lock_guard<std::mutex> response_sinks_guard(m_hw_cmd_response_sinks_mutex);
+    m_hw_cmd_response_sinks.erase(hw_cmd.response_queue);
+    return;
+  }
+
+  // a controller which has stopped waiting may not be reading its responses any more, so don't wait for room in
+  // its queue: the strand has the next hw cmd to execute
+  try {
+    response_sink->push(std::move(response), s_hw_cmd_response_timeout);
+  } catch (const dunedaq::appfwk::QueueTimeoutExpired&) {
+    ++m_dropped_hw_cmd_responses_counter;
+    TLOG_DEBUG(0) << get_name() << ": dropped the response to " << get_hw_cmd_name(hw_cmd.id) << " for "
+                  << hw_cmd.device << ", as " << hw_cmd.response_queue << " is full";
+  }
+}
+
 template<class Child>
 void
-TimingHardwareManager::register_timing_hw_command(const std::string& hw_cmd_id,
+TimingHardwareManager::register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
                                                   const std::string& design_type,
                                                   void (Child::*f)(const timingcmd::TimingHwCmd&))
 {
   using namespace std::placeholders;
+  // the bound handler ignores the result argument
+  register_timing_hw_command(
+    hw_cmd_id, design_type, timing_hw_cmd_handler_t(std::bind(f, dynamic_cast<Child*>(this), _1)), typeid(f).name());
+}
+
+template<class Child>
+void
+TimingHardwareManager::register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
+                                                  const std::string& design_type,
+                                                  void (Child::*f)(const timingcmd::TimingHwCmd&, nlohmann::json&))
+{
+  using namespace std::placeholders;
+  register_timing_hw_command(
+    hw_cmd_id, design_type, std::bind(f, dynamic_cast<Child*>(this), _1, _2), typeid(f).name());
+}
 
-  std::string hw_cmd_name = hw_cmd_id + "_" + design_type;
-  TLOG_DEBUG(0) << "Registering timing hw command id: " << hw_cmd_name << " called with " << typeid(f).name()
+void
+TimingHardwareManager::register_timing_hw_command(timingcmd::TimingHwCmdId hw_cmd_id,
+                                                  const std::string& design_type,
+                                                  timing_hw_cmd_handler_t hw_cmd_handler,
+                                                  const std::string& handler_type)
+{
+  std::string hw_cmd_name = get_hw_cmd_name(hw_cmd_id, design_type);
+  TLOG_DEBUG(0) << "Registering timing hw command id: " << hw_cmd_name << " called with " << handler_type
                 << std::endl;
 
-  bool done = m_timing_hw_cmd_map_.emplace(hw_cmd_name, std::bind(f, dynamic_cast<Child*>(this), _1)).second;
-  if (!done) {
+  auto& hw_cmds = m_timing_hw_cmd_map_[design_type];
+  auto cmd_index = static_cast<size_t>(hw_cmd_id);
+  if (hw_cmds.size() <= cmd_index) {
+    hw_cmds.resize(cmd_index + 1);
+  }
+  if (hw_cmds.at(cmd_index)) {
     throw TimingHardwareCommandRegistrationFailed(ERS_HERE, hw_cmd_name, get_name());
   }
+  hw_cmds.at(cmd_index) = std::move(hw_cmd_handler);
 }
 
-template<class TIMING_DEV>
-const TIMING_DEV&
-TimingHardwareManager::get_timing_device(const std::string& device_name)
+std::shared_ptr<TimingHardwareManager::HwDevice>
+TimingHardwareManager::create_hw_device(const std::string& device_name) const
 {
+  auto hw_device = std::make_shared<HwDevice>();
+  try {
+    hw_device->hw_interface = std::make_unique<uhal::HwInterface>(m_connection_manager->getDevice(device_name));
+  } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
+    std::stringstream message;
+    message << "UHAL device name not " << device_name << " in connections file";
+    throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
+  }
 
+  // the design type never changes for a device, so it is resolved only here
+  hw_device->design_type = typeid(hw_device->hw_interface->getNode("")).name();
+  auto hw_cmds = m_timing_hw_cmd_map_.find(hw_device->design_type);
+  hw_device->hw_cmds = hw_cmds == m_timing_hw_cmd_map_.end() ? nullptr : &hw_cmds->second;
+
+  TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name
+                << " successfully created, with design: " << hw_device->design_type;
+  return hw_device;
+}
+
+const TimingHardwareManager::HwDevice&
+TimingHardwareManager::get_hw_device(const std::string& device_name)
+{
   if (!device_name.compare("")) {
     std::stringstream message;
     message << "UHAL device name is an empty string";
     throw UHALDeviceNameIssue(ERS_HERE, message.str());
   }
 
-  std::lock_guard<std::mutex> hw_device_map_guard(m_hw_device_map_mutex);
+  auto hw_device_registry = m_hw_device_registry.load(std::memory_order_acquire);
+  if (hw_device_registry) {
+    if (auto hw_device_entry = hw_device_registry->find(device_name); hw_device_entry != hw_device_registry->end()) {
+      return *hw_device_entry->second;
+    }
+  }
 
-  if (auto hw_device_entry = m_hw_device_map.find(device_name); hw_device_entry != m_hw_device_map.end()) {
-    return hw_device_entry->second->getNode<TIMING_DEV>("");
-  } else {
-    TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name
-                  << " does not exist. I will try to create it.";
+  // only the threads adding devices wait for each other
+  std::lock_guard<std::mutex> update_guard(m_hw_device_registry_update_mutex);
+  hw_device_registry = m_hw_device_registry.load(std::memory_order_relaxed);
+  if (hw_device_registry) {
+    if (auto hw_device_entry = hw_device_registry->find(device_name); hw_device_entry != hw_device_registry->end()) {
+      return *hw_device_entry->second;
+    }
+  }
+
+  TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name
+                << " does not exist. I will try to create it.";
+
+  std::shared_ptr<const HwDevice> hw_device = create_hw_device(device_name);
+  auto new_hw_device_registry = hw_device_registry ? std::make_unique<hw_device_registry_t>(*hw_device_registry)
+                                                   : std::make_unique<hw_device_registry_t>();
+  new_hw_device_registry->emplace(device_name, hw_device);
+  publish_hw_device_registry(std::move(new_hw_device_registry));
+  return *hw_device;
+}
 
+void
+TimingHardwareManager::publish_hw_device_registry(std::unique_ptr<const hw_device_registry_t> hw_device_registry)
+{
+  // the registry replaced may still be in use by lookups, so it is kept as well
+  m_hw_device_registry.store(hw_device_registry.get(), std::memory_order_release);
+  m_hw_device_registries.push_back(std::move(hw_device_registry));
+}
+
+void
+TimingHardwareManager::warm_up_hw_devices(const std::vector<std::string>& device_names)
+{
+  std::map<std::string, std::future<std::shared_ptr<HwDevice>>> warm_ups;
+  for (auto& device_name : device_names) {
+    if (device_name.empty() || warm_ups.count(device_name)) {
+      continue;
+    }
+    warm_ups.emplace(device_name, std::async(std::launch::async, [this, device_name]() {
+                       auto hw_device = create_hw_device(device_name);
+                       read_hw_device_register(device_name, *hw_device->hw_interface);
+                       return hw_device;
+                     }));
+  }
+
+  auto new_hw_device_registry = std::make_unique<hw_device_registry_t>();
+  for (auto& [device_name, warm_up] : warm_ups) {
     try {
-      m_hw_device_map.emplace(device_name,
-                              std::make_unique<uhal::HwInterface>(m_connection_manager->getDevice(device_name)));
-    } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
-      std::stringstream message;
-      message << "UHAL device name not " << device_name << " in connections file";
-      throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
+      new_hw_device_registry->emplace(device_name, warm_up.get());
+    } catch (const std::exception& excpt) {
+      // the device is tried again when it is first used
+      ers::warning(FailedToWarmUpHwDevice(ERS_HERE, device_name, excpt));
     }
+  }
+
+  TLOG() << get_name() << ": warmed up " << new_hw_device_registry->size() << " of " << warm_ups.size()
+         << " hw devices";
+  std::lock_guard<std::mutex> update_guard(m_hw_device_registry_update_mutex);
+  publish_hw_device_registry(std::move(new_hw_device_registry));
+}
 
-    TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name << " successfully created.";
+void
+TimingHardwareManager::read_hw_device_register(const std::string& device_name, uhal::HwInterface& hw_interface) const
+{
+  // a ping only shows that something answers at the address; reading a register also checks the address table
+  // against the firmware
+  const auto& design = hw_interface.getNode("");
+  std::string register_id;
+  for (auto& node_id : design.getNodes()) {
+    const auto& node = design.getNode(node_id);
+    if (!(node.getPermission() & uhal::defs::READ) || node.getMode() != uhal::defs::SINGLE) {
+      continue;
+    }
+    if (register_id.empty()) {
+      register_id = node_id;
+    }
+    if (node_id.size() >= 7 && node_id.compare(node_id.size() - 7, 7, "version") == 0) {
+      register_id = node_id;
+      break;
+    }
+  }
+  if (register_id.empty()) {
+    throw UHALDeviceNodeIssue(ERS_HERE, "no readable register in the address table of " + device_name);
+  }
 
-    return m_hw_device_map.find(device_name)->second->getNode<TIMING_DEV>("");
+  auto value = design.getNode(register_id).read();
+  hw_interface.dispatch();
+  TLOG_DEBUG(0) << get_name() << ": " << device_name << " " << register_id << " reads 0x" << std::hex << value.value();
+}
+
+void
+TimingHardwareManager::clear_hw_devices()
+{
+  {
+    std::lock_guard<std::mutex> update_guard(m_hw_device_registry_update_mutex);
+    m_hw_device_registry.store(nullptr, std::memory_order_release);
+    m_hw_device_registries.clear();
+  }
+  // nothing is known about the hw of devices which are connected to again
+  std::lock_guard<std::mutex> lk(m_hw_config_shadows_mutex);
+  m_hw_config_shadows.clear();
+}
+
+bool
+TimingHardwareManager::is_hw_config_applied(const std::string& device_name,
+                                            const std::string& target,
+                                            const nlohmann::json& config)
+{
+  std::lock_guard<std::mutex> lk(m_hw_config_shadows_mutex);
+  auto device_shadow = m_hw_config_shadows.find(device_name);
+  if (device_shadow == m_hw_config_shadows.end()) {
+    return false;
+  }
+  auto target_shadow = device_shadow->second.find(target);
+  return target_shadow != device_shadow->second.end() && target_shadow->second == config;
+}
+
+void
+TimingHardwareManager::set_hw_config_applied(const std::string& device_name,
+                                             const std::string& target,
+                                             const nlohmann::json& config)
+{
+  std::lock_guard<std::mutex> lk(m_hw_config_shadows_mutex);
+  m_hw_config_shadows[device_name][target] = config;
+}
+
+void
+TimingHardwareManager::invalidate_hw_config(const std::string& device_name, const std::string& target)
+{
+  std::lock_guard<std::mutex> lk(m_hw_config_shadows_mutex);
+  if (target.empty()) {
+    m_hw_config_shadows.erase(device_name);
+  } else if (auto device_shadow = m_hw_config_shadows.find(device_name); device_shadow != m_hw_config_shadows.end()) {
+    device_shadow->second.erase(target);
   }
 }
 
+std::string
+TimingHardwareManager::get_partition_config_target(uint32_t partition_id) // NOLINT(build/unsigned)
+{
+  return "partition" + std::to_string(partition_id);
+}
+
+void
+TimingHardwareManager::invalidate_partition_config(const std::string& device_name,
+                                                   uint32_t partition_id) // NOLINT(build/unsigned)
+{
+  // the partition is no longer in the state its configure left it in
+  invalidate_hw_config(device_name, get_partition_config_target(partition_id));
+}
+
+template<class TIMING_DEV>
+const TIMING_DEV&
+TimingHardwareManager::get_timing_device(const std::string& device_name)
+{
+  return get_hw_device(device_name).hw_interface->getNode<TIMING_DEV>("");
+}
+
 // common commands
 template<class DSGN>
 void
@@ -284,7 +938,8 @@ TimingHardwareManager::io_reset(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
   
   stop_hw_mon_gathering(hw_cmd.device);
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device);
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
 
   if (cmd_payload.soft) {
     TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " soft io reset";
@@ -305,7 +960,8 @@ TimingHardwareManager::io_reset<timing::FanoutDesign<timing::PC059IONode, timing
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
   
   stop_hw_mon_gathering(hw_cmd.device);
-  auto design = get_timing_device<timing::FanoutDesign<timing::PC059IONode, timing::PDIMasterNode>>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device);
+  const auto& design = get_timing_device<timing::FanoutDesign<timing::PC059IONode, timing::PDIMasterNode>>(hw_cmd.device);
 
   if (cmd_payload.soft) {
     TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " soft io reset";
@@ -320,11 +976,13 @@ TimingHardwareManager::io_reset<timing::FanoutDesign<timing::PC059IONode, timing
 
 template<class DSGN>
 void
-TimingHardwareManager::print_status(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " print status";
-  TLOG() << std::endl << design.get_status();
+  std::string status = design.get_status();
+  TLOG() << std::endl << status;
+  result["status"] = status;
 }
 
 // master commands
@@ -332,7 +990,7 @@ template<class DSGN>
 void
 TimingHardwareManager::set_timestamp(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " set timestamp";
   design.get_master_node().sync_timestamp();
 }
@@ -340,18 +998,34 @@ TimingHardwareManager::set_timestamp(const timingcmd::TimingHwCmd& hw_cmd)
 // partition commands
 template<class DSGN>
 void
-TimingHardwareManager::partition_configure(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::partition_configure(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
   timingcmd::TimingPartitionConfigureCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  // the partition is reset as part of configuring it, so this is skipped only while nothing else has been done to
+  // the partition since it was configured
+  auto target = get_partition_config_target(cmd_payload.partition_id);
+  nlohmann::json config;
+  timingcmd::to_json(config, cmd_payload);
+  config.erase("force");
+  if (!cmd_payload.force && is_hw_config_applied(hw_cmd.device, target, config)) {
+    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id
+                  << " already configured";
+    ++m_skipped_hw_commands_counter;
+    result["skipped"] = true;
+    return;
+  }
+  invalidate_hw_config(hw_cmd.device, target);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
 
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " configure";
 
   partition.reset();
   partition.configure(cmd_payload.trigger_mask, cmd_payload.spill_gate_enabled, cmd_payload.rate_control_enabled);
+  set_hw_config_applied(hw_cmd.device, target, config);
 }
 
 template<class DSGN>
@@ -361,8 +1035,10 @@ TimingHardwareManager::partition_enable(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
 
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " enable";
   partition.enable(true);
@@ -375,8 +1051,10 @@ TimingHardwareManager::partition_disable(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " disable";
   partition.enable(false);
 }
@@ -388,8 +1066,10 @@ TimingHardwareManager::partition_start(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " start";
   partition.start();
 }
@@ -401,8 +1081,10 @@ TimingHardwareManager::partition_stop(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " stop";
   partition.stop();
 }
@@ -414,8 +1096,10 @@ TimingHardwareManager::partition_enable_triggers(const timingcmd::TimingHwCmd& h
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id
                 << " start triggers";
   partition.enable_triggers(true);
@@ -428,47 +1112,64 @@ TimingHardwareManager::partition_disable_triggers(const timingcmd::TimingHwCmd&
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  invalidate_partition_config(hw_cmd.device, cmd_payload.partition_id);
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " partition " << cmd_payload.partition_id << " stop triggers";
   partition.enable_triggers(false);
 }
 
 template<class DSGN>
 void
-TimingHardwareManager::partition_print_status(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::partition_print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
   timingcmd::TimingPartitionCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<DSGN>(hw_cmd.device);
-  auto partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& partition = design.get_master_node().get_partition_node(cmd_payload.partition_id);
 
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " print partition " << cmd_payload.partition_id << " status";
-  TLOG() << std::endl << partition.get_status();
+  std::string status = partition.get_status();
+  TLOG() << std::endl << status;
+  result["status"] = status;
 }
 
 // endpoint commands
 template<class DSGN>
 void
-TimingHardwareManager::endpoint_enable(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::endpoint_enable(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
   timingcmd::TimingEndpointConfigureCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  // the cmds only ever act on endpoint 0
+  nlohmann::json config = { { "address", cmd_payload.address }, { "partition", cmd_payload.partition } };
+  if (!cmd_payload.force && is_hw_config_applied(hw_cmd.device, "endpoint", config)) {
+    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept already enabled, adr: " << cmd_payload.address
+                  << ", part: " << cmd_payload.partition;
+    ++m_skipped_hw_commands_counter;
+    result["skipped"] = true;
+    return;
+  }
+  invalidate_hw_config(hw_cmd.device, "endpoint");
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept enable, adr: " << cmd_payload.address
                 << ", part: " << cmd_payload.partition;
-  desgin.get_endpoint_node(0).enable(cmd_payload.partition, cmd_payload.address);
+  design.get_endpoint_node(0).enable(cmd_payload.partition, cmd_payload.address);
+  set_hw_config_applied(hw_cmd.device, "endpoint", config);
 }
 
 template<class DSGN>
 void
 TimingHardwareManager::endpoint_disable(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device, "endpoint");
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept disable";
-  desgin.get_endpoint_node(0).disable();
+  design.get_endpoint_node(0).disable();
 }
 
 template<class DSGN>
@@ -478,60 +1179,89 @@ TimingHardwareManager::endpoint_reset(const timingcmd::TimingHwCmd& hw_cmd)
   timingcmd::TimingEndpointConfigureCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device, "endpoint");
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept reset, adr: " << cmd_payload.address
                 << ", part: " << cmd_payload.partition;
-  desgin.get_endpoint_node(0).reset(cmd_payload.partition, cmd_payload.address);
+  design.get_endpoint_node(0).reset(cmd_payload.partition, cmd_payload.address);
+}
+
+template<class DSGN>
+void
+TimingHardwareManager::endpoint_print_timestamp(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
+{
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept print timestamp";
+  auto timestamp = design.get_endpoint_node(0).read_timestamp();
+  TLOG() << hw_cmd.device << " endpoint timestamp: " << timestamp;
+  result["timestamp"] = timestamp;
 }
 
 template<class DSGN>
 void
 TimingHardwareManager::hsi_reset(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device, "hsi");
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi reset";
-  desgin.get_hsi_node().reset_hsi();
+  design.get_hsi_node().reset_hsi();
 }
 
 template<class DSGN>
 void
-TimingHardwareManager::hsi_configure(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::hsi_configure(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
   timingcmd::HSIConfigureCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  nlohmann::json config;
+  timingcmd::to_json(config, cmd_payload);
+  config.erase("force");
+  if (!cmd_payload.force && is_hw_config_applied(hw_cmd.device, "hsi", config)) {
+    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi already configured";
+    ++m_skipped_hw_commands_counter;
+    result["skipped"] = true;
+    return;
+  }
+  invalidate_hw_config(hw_cmd.device, "hsi");
+
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi configure";
 
-  desgin.get_hsi_node().configure_hsi(
+  design.get_hsi_node().configure_hsi(
     cmd_payload.data_source, cmd_payload.rising_edge_mask, cmd_payload.falling_edge_mask, cmd_payload.invert_edge_mask);
+  set_hw_config_applied(hw_cmd.device, "hsi", config);
 }
 
 template<class DSGN>
 void
 TimingHardwareManager::hsi_start(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device, "hsi");
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi start";
-  desgin.get_hsi_node().start_hsi();
+  design.get_hsi_node().start_hsi();
 }
 
 template<class DSGN>
 void
 TimingHardwareManager::hsi_stop(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  invalidate_hw_config(hw_cmd.device, "hsi");
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi stop";
-  desgin.get_hsi_node().stop_hsi();
+  design.get_hsi_node().stop_hsi();
 }
 
 template<class DSGN>
 void
-TimingHardwareManager::hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd)
+TimingHardwareManager::hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd, nlohmann::json& result)
 {
-  auto desgin = get_timing_device<DSGN>(hw_cmd.device);
+  const auto& design = get_timing_device<DSGN>(hw_cmd.device);
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi print status";
-  desgin.get_hsi_node().get_status();
+  std::string status = design.get_hsi_node().get_status();
+  TLOG() << std::endl << status;
+  result["status"] = status;
 }
 
 } // namespace dunedaq::timinglibs
@@ -0,0 +1,308 @@
+/**
+ * @file timestamp_estimator_benchmark.cxx
+ *
+ * Measures the call cost, the wait wake-up latency and the accuracy of
+ * the timestamp estimators, and writes the results as JSON to stdout,
+ * or to the file given with -o.
+ *
+ * Accuracy is measured on a VirtualClock with synthetic TimeSync
+ * streams, so it is reproducible and takes seconds rather than the
+ * minutes of simulated time. Use --quick for a shorter run.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/Clock.hpp"
+#include "timinglibs/TimestampEstimator.hpp"
+#include "timinglibs/TimestampEstimatorSystem.hpp"
+
+#include "dfmessages/TimeSync.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+namespace {
+
+const uint64_t s_clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+
+std::atomic<dfmessages::timestamp_t> g_sink{ 0 };
+
+nlohmann::json
+summarize(std::vector<double> values)
+{
+  nlohmann::json summary;
+  summary["count"] = values.size();
+  if (values.empty()) {
+    return summary;
+  }
+  std::sort(values.begin(), values.end());
+  auto percentile = [&](double p) { return values[std::min(values.size() - 1, size_t(p * values.size()))]; };
+  double sum = 0.;
+  for (auto value : values)
+    sum += value;
+  summary["mean"] = sum / values.size();
+  summary["p50"] = percentile(0.5);
+  summary["p90"] = percentile(0.9);
+  summary["p99"] = percentile(0.99);
+  summary["max"] = values.back();
+  return summary;
+}
+
+// Cost of get_timestamp_estimate() with n_threads threads calling it
+// as fast as they can for duration
+nlohmann::json
+measure_call_cost(const timinglibs::TimestampEstimatorBase& estimator,
+                  size_t n_threads,
+                  std::chrono::milliseconds duration)
+{
+  std::atomic<bool> go{ false };
+  std::vector<double> ns_per_call(n_threads);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n_threads; ++i) {
+    threads.emplace_back([&, i]() {
+      while (!go.load()) {
+      }
+      dfmessages::timestamp_t sink = 0;
+      uint64_t n_calls = 0; // NOLINT(build/unsigned)
+      auto start = std::chrono::steady_clock::now();
+      auto end = start + duration;
+      auto now = start;
+      do {
+        for (int j = 0; j < 1000; ++j)
+          sink ^= estimator.get_timestamp_estimate();
+        n_calls += 1000;
+        now = std::chrono::steady_clock::now();
+      } while (now < end);
+      ns_per_call[i] = std::chrono::duration<double, std::nano>(now - start).count() / n_calls;
+      // so that the calls can't be optimised away
+      g_sink.fetch_xor(sink);
+    });
+  }
+  go.store(true);
+  for (auto& thread : threads)
+    thread.join();
+
+  nlohmann::json result;
+  result["threads"] = n_threads;
+  result["ns_per_call"] = summarize(ns_per_call);
+  return result;
+}
+
+// How late wait_for_timestamp() and call_at_timestamp() return with
+// respect to the moment the estimate reaches their target
+nlohmann::json
+measure_wake_latency(timinglibs::TimestampEstimatorBase& estimator, int n_waits, std::chrono::microseconds lead)
+{
+  const double ns_per_tick = 1e9 / s_clock_frequency_hz;
+  const auto lead_ticks = static_cast<dfmessages::timestamp_t>(lead.count() * 1e-6 * s_clock_frequency_hz);
+  std::atomic<bool> continue_flag{ true };
+
+  std::vector<double> sync_latency;
+  for (int i = 0; i < n_waits; ++i) {
+    dfmessages::timestamp_t target = estimator.get_timestamp_estimate() + lead_ticks;
+    estimator.wait_for_timestamp(target, continue_flag);
+    sync_latency.push_back((estimator.get_timestamp_estimate() - target) * ns_per_tick);
+  }
+
+  std::vector<double> async_latency(n_waits);
+  std::vector<std::future<void>> done;
+  for (int i = 0; i < n_waits; ++i) {
+    dfmessages::timestamp_t target = estimator.get_timestamp_estimate() + (i + 1) * lead_ticks;
+    auto promise = std::make_shared<std::promise<void>>();
+    done.push_back(promise->get_future());
+    estimator.call_at_timestamp(target, [&, i, target, promise](timinglibs::TimestampEstimatorBase::WaitStatus) {
+      async_latency[i] = (estimator.get_timestamp_estimate() - target) * ns_per_tick;
+      promise->set_value();
+    });
+  }
+  for (auto& future : done)
+    future.wait();
+
+  nlohmann::json result;
+  result["lead_us"] = lead.count();
+  result["sync_ns"] = summarize(sync_latency);
+  result["async_ns"] = summarize(async_latency);
+  return result;
+}
+
+struct Scenario
+{
+  std::string name;
+  double drift_ppm;                     // of the DAQ clock with respect to the host clock
+  double jitter_us;                     // rms error of the TimeSync system times
+  std::chrono::milliseconds max_lag;    // TimeSyncs are delivered up to this long after they are made
+  std::chrono::seconds gap_start;       // no TimeSyncs are made in [gap_start, gap_start + gap_length)
+  std::chrono::seconds gap_length;
+  std::chrono::seconds duration;
+};
+
+// Error of TimestampEstimator under a synthetic TimeSync stream, one
+// TimeSync every 100 ms, sampled every 10 ms of simulated time
+nlohmann::json
+measure_accuracy(const Scenario& scenario)
+{
+  const int64_t system_start = 1'600'000'000'000'000'000;
+  const dfmessages::timestamp_t daq_start = 1'000'000'000'000;
+  const double true_rate = s_clock_frequency_hz * (1. + scenario.drift_ppm * 1e-6);
+  auto daq_time_at = [&](int64_t system_time) {
+    return daq_start + std::llround((system_time - system_start) * 1e-9 * true_rate);
+  };
+
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator estimator(s_clock_frequency_hz, clock);
+
+  std::mt19937_64 random_engine(12345);
+  std::normal_distribution<double> jitter(0., scenario.jitter_us * 1000.);
+  std::uniform_int_distribution<int64_t> lag(0, std::chrono::nanoseconds(scenario.max_lag).count());
+
+  std::multimap<int64_t, dfmessages::TimeSync> in_flight; // by delivery time
+  std::vector<double> abs_error, abs_error_in_gap;
+  size_t bound_violations = 0;
+
+  const int64_t step = std::chrono::nanoseconds(1ms).count();
+  const int64_t n_steps = std::chrono::nanoseconds(scenario.duration).count() / step;
+  const int64_t gap_start = std::chrono::nanoseconds(scenario.gap_start).count() / step;
+  const int64_t gap_end = gap_start + std::chrono::nanoseconds(scenario.gap_length).count() / step;
+  for (int64_t i = 0; i < n_steps; ++i, clock->advance(1ms)) {
+    int64_t now = clock->system_time_ns();
+    bool in_gap = i >= gap_start && i < gap_end;
+    if (i % 100 == 0 && !in_gap) {
+      dfmessages::TimeSync timesync(daq_time_at(now));
+      timesync.system_time = static_cast<uint64_t>((now + std::llround(jitter(random_engine))) / 1000); // NOLINT
+      in_flight.emplace(now + lag(random_engine), timesync);
+    }
+    while (!in_flight.empty() && in_flight.begin()->first <= now) {
+      estimator.add_timesync(in_flight.begin()->second);
+      in_flight.erase(in_flight.begin());
+    }
+
+    if (i % 10 == 0) {
+      dfmessages::timestamp_t estimate = estimator.get_timestamp_estimate();
+      if (estimate == dfmessages::TypeDefaults::s_invalid_timestamp) {
+        continue;
+      }
+      double error = std::abs(static_cast<double>(static_cast<int64_t>(estimate - daq_time_at(now))));
+      (in_gap ? abs_error_in_gap : abs_error).push_back(error);
+      if (error > estimator.get_timestamp_estimate_error()) {
+        ++bound_violations;
+      }
+    }
+  }
+
+  nlohmann::json result;
+  result["scenario"] = scenario.name;
+  result["drift_ppm"] = scenario.drift_ppm;
+  result["jitter_us"] = scenario.jitter_us;
+  result["max_lag_ms"] = scenario.max_lag.count();
+  result["gap_s"] = scenario.gap_length.count();
+  result["simulated_s"] = scenario.duration.count();
+  result["abs_error_ticks"] = summarize(abs_error);
+  result["abs_error_in_gap_ticks"] = summarize(abs_error_in_gap);
+  result["samples_outside_error_bound"] = bound_violations;
+  return result;
+}
+
+void
+print_usage(const char* argv0)
+{
+  std::cerr << "Usage: " << argv0 << " [--quick] [-o output.json]" << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  bool quick = false;
+  std::string output_file;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quick") {
+      quick = true;
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  const auto call_duration = quick ? 100ms : 1000ms;
+  const int n_waits = quick ? 20 : 200;
+  const std::chrono::seconds simulated = quick ? 120s : 600s;
+
+  std::vector<size_t> thread_counts{ 1, 2, 4 };
+  thread_counts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+  std::sort(thread_counts.begin(), thread_counts.end());
+  thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+  // The estimators under test, on the real clock. The TimeSync-based
+  // one is given a single TimeSync, so it extrapolates at the nominal rate
+  std::map<std::string, std::shared_ptr<timinglibs::TimestampEstimatorBase>> estimators;
+  auto timesync_estimator =
+    std::make_shared<timinglibs::TimestampEstimator>(s_clock_frequency_hz, timinglibs::SystemClock::get());
+  timesync_estimator->add_timesync(dfmessages::TimeSync(
+    timinglibs::TimestampEstimatorSystem(s_clock_frequency_hz).get_timestamp_estimate()));
+  estimators["TimestampEstimator"] = timesync_estimator;
+  estimators["TimestampEstimatorSystem"] = std::make_shared<timinglibs::TimestampEstimatorSystem>(s_clock_frequency_hz);
+  auto tsc_estimator = std::make_shared<timinglibs::TimestampEstimatorSystem>(s_clock_frequency_hz, true);
+  if (tsc_estimator->is_using_tsc()) {
+    estimators["TimestampEstimatorSystem_tsc"] = tsc_estimator;
+  }
+
+  nlohmann::json results;
+  results["clock_frequency_hz"] = s_clock_frequency_hz;
+  for (auto& [name, estimator] : estimators) {
+    std::cerr << "Measuring " << name << std::endl;
+    nlohmann::json& estimator_results = results["estimators"][name];
+    for (auto n_threads : thread_counts) {
+      estimator_results["call_cost"].push_back(measure_call_cost(*estimator, n_threads, call_duration));
+    }
+    for (auto lead : { 100us, 10000us }) {
+      estimator_results["wake_latency"].push_back(measure_wake_latency(*estimator, n_waits, lead));
+    }
+  }
+
+  const std::vector<Scenario> scenarios{
+    { "nominal", 0., 0., 0ms, 0s, 0s, simulated },
+    { "jitter", 0., 20., 5ms, 0s, 0s, simulated },
+    { "drift", 50., 0., 0ms, 0s, 0s, simulated },
+    { "drift_jitter_lag", 50., 20., 50ms, 0s, 0s, simulated },
+    { "gap", 50., 20., 5ms, simulated / 2, 10s, simulated },
+  };
+  for (auto& scenario : scenarios) {
+    std::cerr << "Simulating " << scenario.name << std::endl;
+    results["accuracy"].push_back(measure_accuracy(scenario));
+  }
+
+  if (output_file.empty()) {
+    std::cout << results.dump(2) << std::endl;
+  } else {
+    std::ofstream out(output_file);
+    out << results.dump(2) << std::endl;
+    if (!out) {
+      std::cerr << "Failed to write " << output_file << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file ClockModel_test.cxx  ClockModel class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/ClockModel.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE ClockModel_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+const int64_t host_start = 1'600'000'000'000'000'000;
+const dfmessages::timestamp_t daq_start = 1'000'000'000'000;
+const int64_t timesync_period = 100'000'000; // 100 ms in ns
+
+dfmessages::timestamp_t
+daq_time_at(int64_t host_time, double rate_hz)
+{
+  return daq_start + std::llround((host_time - host_start) * 1e-9 * rate_hz);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SinglePoint)
+{
+  timinglibs::ClockModel model(clock_frequency_hz);
+  BOOST_CHECK(!model.get_snapshot().valid);
+
+  BOOST_CHECK_EQUAL(model.add_point(daq_start, host_start, host_start), 0);
+  const auto& snapshot = model.get_snapshot();
+  BOOST_REQUIRE(snapshot.valid);
+
+  // With a single point, we extrapolate at the nominal rate
+  BOOST_CHECK_EQUAL(snapshot.predict(host_start), daq_start);
+  BOOST_CHECK_EQUAL(snapshot.predict(host_start + 1'000'000'000), daq_start + clock_frequency_hz);
+  BOOST_CHECK_GT(snapshot.error_bound(host_start + 1'000'000'000), snapshot.error_bound(host_start));
+  BOOST_CHECK_EQUAL(snapshot.host_time_for(daq_start + clock_frequency_hz), host_start + 1'000'000'000);
+}
+
+BOOST_AUTO_TEST_CASE(FitsDrift)
+{
+  // A DAQ clock running 50 ppm fast with respect to the host clock
+  const double true_rate = clock_frequency_hz * (1. + 50e-6);
+  timinglibs::ClockModel model(clock_frequency_hz);
+
+  int64_t host_time = host_start;
+  for (int i = 0; i < 64; ++i, host_time += timesync_period) {
+    model.add_point(daq_time_at(host_time, true_rate), host_time, host_time);
+  }
+
+  const auto& snapshot = model.get_snapshot();
+  BOOST_CHECK_CLOSE(snapshot.rate_hz, true_rate, 1e-4);
+
+  // A nominal-rate extrapolation would be off by 50 ppm * 10 s = 31250 ticks
+  int64_t later = host_time + 10'000'000'000;
+  int64_t error = static_cast<int64_t>(snapshot.predict(later) - daq_time_at(later, true_rate));
+  BOOST_CHECK_LT(std::abs(error), 100);
+  BOOST_CHECK_GE(static_cast<int64_t>(snapshot.error_bound(later)), std::abs(error));
+}
+
+BOOST_AUTO_TEST_CASE(RejectsOutliers)
+{
+  timinglibs::ClockModel model(clock_frequency_hz);
+
+  int64_t host_time = host_start;
+  for (int i = 0; i < 32; ++i, host_time += timesync_period) {
+    dfmessages::timestamp_t daq_time = daq_time_at(host_time, clock_frequency_hz);
+    // every eighth point comes from a source whose host clock is 5 ms off
+    if (i % 8 == 7) {
+      daq_time += clock_frequency_hz / 200;
+    }
+    model.add_point(daq_time, host_time, host_time);
+  }
+
+  const auto& snapshot = model.get_snapshot();
+  BOOST_CHECK_CLOSE(snapshot.rate_hz, static_cast<double>(clock_frequency_hz), 1e-4);
+  int64_t error = static_cast<int64_t>(snapshot.predict(host_time) - daq_time_at(host_time, clock_frequency_hz));
+  BOOST_CHECK_LT(std::abs(error), 100);
+}
+
+BOOST_AUTO_TEST_CASE(SlewsSmallCorrections)
+{
+  timinglibs::ClockModel model(clock_frequency_hz, 4);
+
+  int64_t host_time = host_start;
+  for (int i = 0; i < 4; ++i, host_time += timesync_period) {
+    model.add_point(daq_time_at(host_time, clock_frequency_hz), host_time, host_time);
+  }
+
+  // Shift the DAQ clock by 1 ms. The prediction must stay continuous
+  // at the switch-over and then converge on the new fit
+  const dfmessages::timestamp_t shift = clock_frequency_hz / 1000;
+  const int64_t now = host_time;
+  dfmessages::timestamp_t before = model.get_snapshot().predict(now);
+  for (int i = 0; i < 4; ++i, host_time += 1000) {
+    model.add_point(daq_time_at(host_time, clock_frequency_hz) + shift, host_time, now);
+  }
+  const auto& snapshot = model.get_snapshot();
+  BOOST_CHECK_EQUAL(snapshot.predict(now), before);
+  BOOST_CHECK_GT(snapshot.slew_end_host_time, now);
+  BOOST_CHECK_GT(snapshot.slew_rate_hz, 0.);
+
+  int64_t after_slew = snapshot.slew_end_host_time + 1'000'000;
+  int64_t error = static_cast<int64_t>(snapshot.predict(after_slew) -
+                                       (daq_time_at(after_slew, clock_frequency_hz) + shift));
+  BOOST_CHECK_LT(std::abs(error), 2'000);
+}
+
+BOOST_AUTO_TEST_CASE(JumpsLargeCorrections)
+{
+  timinglibs::ClockModel model(clock_frequency_hz, 1);
+  model.add_point(daq_start, host_start, host_start);
+
+  // A 10 s step is applied immediately
+  const dfmessages::timestamp_t step = 10 * clock_frequency_hz;
+  model.add_point(daq_start + step, host_start, host_start);
+  BOOST_CHECK_EQUAL(model.get_snapshot().predict(host_start), daq_start + step);
+
+  model.reset();
+  BOOST_CHECK(!model.get_snapshot().valid);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+/**
+ * @file Clock_test.cxx  Clock classes Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/Clock.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE Clock_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <future>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(SystemClock)
+{
+  auto clock = timinglibs::SystemClock::get();
+  BOOST_CHECK_EQUAL(clock.get(), timinglibs::SystemClock::get().get());
+
+  int64_t before = clock->steady_time_ns();
+  clock->sleep_for(1ms);
+  BOOST_CHECK_GE(clock->steady_time_ns() - before, 1'000'000);
+  BOOST_CHECK_GT(clock->system_time_ns(), 1'600'000'000'000'000'000);
+}
+
+BOOST_AUTO_TEST_CASE(VirtualClockMovesOnlyWhenTold)
+{
+  timinglibs::VirtualClock clock(1'000'000'000, 5);
+  BOOST_CHECK_EQUAL(clock.system_time_ns(), 1'000'000'000);
+  BOOST_CHECK_EQUAL(clock.steady_time_ns(), 5);
+
+  clock.advance(10ns);
+  BOOST_CHECK_EQUAL(clock.system_time_ns(), 1'000'000'010);
+  BOOST_CHECK_EQUAL(clock.steady_time_ns(), 15);
+
+  clock.step_system_time(-1s);
+  BOOST_CHECK_EQUAL(clock.system_time_ns(), 10);
+  BOOST_CHECK_EQUAL(clock.steady_time_ns(), 15);
+}
+
+BOOST_AUTO_TEST_CASE(VirtualClockSleep)
+{
+  timinglibs::VirtualClock clock(0);
+
+  // The sleeper may start at any point of the loop, so just check that
+  // it can't wake before its second has passed
+  auto sleeper = std::async(std::launch::async, [&]() {
+    int64_t start = clock.steady_time_ns();
+    clock.sleep_for(1s);
+    return clock.steady_time_ns() - start;
+  });
+  while (sleeper.wait_for(1ms) != std::future_status::ready) {
+    clock.advance(10ms);
+  }
+  BOOST_CHECK_GE(sleeper.get(), 1'000'000'000);
+}
+
+BOOST_AUTO_TEST_CASE(VirtualClockListeners)
+{
+  timinglibs::VirtualClock clock(0);
+
+  int n_calls = 0;
+  size_t id = clock.add_listener([&]() { ++n_calls; });
+  clock.advance(1s);
+  clock.step_system_time(1s);
+  BOOST_CHECK_EQUAL(n_calls, 2);
+
+  clock.remove_listener(id);
+  clock.advance(1s);
+  BOOST_CHECK_EQUAL(n_calls, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+/**
+ * @file LogHistogram_test.cxx  LogHistogram class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/LogHistogram.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LogHistogram_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+  timinglibs::LogHistogram histogram;
+  BOOST_CHECK_EQUAL(histogram.count(), 0);
+  BOOST_CHECK_EQUAL(histogram.max(), 0);
+  BOOST_CHECK_EQUAL(histogram.mean(), 0.);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0);
+  BOOST_CHECK(histogram.octave_counts().empty());
+}
+
+BOOST_AUTO_TEST_CASE(BinEdges)
+{
+  // The values below 4 each have a bin of their own
+  for (uint64_t value = 0; value < 4; ++value) { // NOLINT(build/unsigned)
+    timinglibs::LogHistogram histogram;
+    histogram.record(value);
+    BOOST_CHECK_EQUAL(histogram.percentile(1.), value);
+  }
+
+  // 7 and 8 are on either side of a power of two
+  timinglibs::LogHistogram histogram;
+  histogram.record(7);
+  histogram.record(8);
+  std::vector<uint64_t> expected = { 0, 0, 0, 1, 1 }; // NOLINT(build/unsigned)
+  auto octaves = histogram.octave_counts();
+  BOOST_CHECK_EQUAL_COLLECTIONS(octaves.begin(), octaves.end(), expected.begin(), expected.end());
+
+  // 8 and 9 share a bin, 10 starts the next one
+  timinglibs::LogHistogram shared;
+  shared.record(8);
+  shared.record(9);
+  shared.record(10);
+  BOOST_CHECK_EQUAL(shared.percentile(2. / 3.), 10);
+  BOOST_CHECK_EQUAL(shared.percentile(1.), 10);
+
+  // The largest values still have a bin
+  timinglibs::LogHistogram largest;
+  largest.record(std::numeric_limits<uint64_t>::max()); // NOLINT(build/unsigned)
+  BOOST_CHECK_EQUAL(largest.max(), std::numeric_limits<uint64_t>::max()); // NOLINT(build/unsigned)
+  BOOST_CHECK_EQUAL(largest.octave_counts().size(), 65);
+}
+
+BOOST_AUTO_TEST_CASE(Percentiles)
+{
+  timinglibs::LogHistogram histogram;
+  for (uint64_t value = 1; value <= 1000; ++value) { // NOLINT(build/unsigned)
+    histogram.record(value);
+  }
+  BOOST_CHECK_EQUAL(histogram.count(), 1000);
+  BOOST_CHECK_EQUAL(histogram.max(), 1000);
+  BOOST_CHECK_CLOSE(histogram.mean(), 500.5, 1e-9);
+
+  // Percentiles are resolved to within 25%
+  for (double q : { 0.1, 0.5, 0.9, 0.99 }) {
+    double exact = q * 1000;
+    BOOST_CHECK_GE(histogram.percentile(q), 0.75 * exact);
+    BOOST_CHECK_LE(histogram.percentile(q), 1.25 * exact);
+  }
+  BOOST_CHECK_LE(histogram.percentile(0.5), histogram.percentile(0.9));
+  BOOST_CHECK_EQUAL(histogram.percentile(1.), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(PercentilesNeverExceedMax)
+{
+  timinglibs::LogHistogram histogram;
+  histogram.record(1025);
+  // 1025 is at the bottom of a bin which is 256 wide
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 1025);
+  BOOST_CHECK_EQUAL(histogram.percentile(1.), 1025);
+}
+
+BOOST_AUTO_TEST_CASE(OctaveCounts)
+{
+  timinglibs::LogHistogram histogram;
+  for (uint64_t value : { 0, 1, 2, 3, 4, 8, 1000 }) { // NOLINT(build/unsigned)
+    histogram.record(value);
+  }
+  // 0 | 1 | 2, 3 | 4 | 8 | ... | 1000 in [512, 1024)
+  std::vector<uint64_t> expected = { 1, 1, 2, 1, 1, 0, 0, 0, 0, 0, 1 }; // NOLINT(build/unsigned)
+  auto octaves = histogram.octave_counts();
+  BOOST_CHECK_EQUAL_COLLECTIONS(octaves.begin(), octaves.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(Reset)
+{
+  timinglibs::LogHistogram histogram;
+  for (uint64_t value = 1; value <= 100; ++value) { // NOLINT(build/unsigned)
+    histogram.record(value);
+  }
+  histogram.reset();
+  BOOST_CHECK_EQUAL(histogram.count(), 0);
+  BOOST_CHECK_EQUAL(histogram.max(), 0);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.99), 0);
+  BOOST_CHECK(histogram.octave_counts().empty());
+
+  histogram.record(5);
+  BOOST_CHECK_EQUAL(histogram.count(), 1);
+  BOOST_CHECK_EQUAL(histogram.max(), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,120 @@
+/**
+ * @file SharedClockModel_test.cxx  SharedClockModel classes Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/SharedClockModel.hpp"
+#include "timinglibs/TimestampEstimatorSharedMemory.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SharedClockModel_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+
+std::string
+segment_name()
+{
+  return "/timinglibs_SharedClockModel_test_" + std::to_string(getpid());
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PublishAndRead)
+{
+  const std::string name = segment_name();
+  shm_unlink(name.c_str());
+
+  // The reader may come up before the publisher
+  timinglibs::SharedClockModelReader reader(name, clock_frequency_hz);
+  BOOST_CHECK(!reader.attach());
+  BOOST_CHECK(!reader.load().valid);
+
+  {
+    timinglibs::SharedClockModelPublisher publisher(name, clock_frequency_hz);
+    BOOST_REQUIRE(reader.attach());
+    BOOST_CHECK(!reader.load().valid);
+
+    timinglibs::ClockModelSnapshot snapshot;
+    snapshot.valid = true;
+    snapshot.anchor_host_time = 1'000'000'000;
+    snapshot.slew_end_host_time = snapshot.anchor_host_time;
+    snapshot.anchor_daq_time = 123'456'789;
+    snapshot.rate_hz = snapshot.slew_rate_hz = clock_frequency_hz;
+    publisher.publish(snapshot);
+
+    auto read_back = reader.load();
+    BOOST_REQUIRE(read_back.valid);
+    BOOST_CHECK_EQUAL(read_back.anchor_daq_time, snapshot.anchor_daq_time);
+    BOOST_CHECK_EQUAL(read_back.predict(2'000'000'000), snapshot.anchor_daq_time + clock_frequency_hz);
+  }
+
+  // The model is withdrawn when its publisher goes away
+  BOOST_CHECK(!reader.load().valid);
+
+  // A new publisher carries on in the segment the reader already has mapped
+  {
+    timinglibs::SharedClockModelPublisher publisher(name, clock_frequency_hz);
+    BOOST_CHECK(reader.attach());
+    BOOST_CHECK(!reader.load().valid);
+
+    timinglibs::ClockModelSnapshot snapshot;
+    snapshot.valid = true;
+    snapshot.rate_hz = snapshot.slew_rate_hz = clock_frequency_hz;
+    publisher.publish(snapshot);
+    BOOST_CHECK(reader.load().valid);
+  }
+
+  // Readers with a different clock frequency don't attach
+  timinglibs::SharedClockModelReader wrong_frequency(name, 2 * clock_frequency_hz);
+  BOOST_CHECK(!wrong_frequency.attach());
+
+  shm_unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Estimator)
+{
+  const std::string name = segment_name();
+  shm_unlink(name.c_str());
+  timinglibs::SharedClockModelPublisher publisher(name, clock_frequency_hz);
+
+  timinglibs::TimestampEstimatorSharedMemory estimator(name, clock_frequency_hz);
+  BOOST_CHECK_EQUAL(estimator.get_timestamp_estimate(), dfmessages::TypeDefaults::s_invalid_timestamp);
+
+  timinglibs::ClockModelSnapshot snapshot;
+  snapshot.valid = true;
+  snapshot.anchor_host_time =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  snapshot.slew_end_host_time = snapshot.anchor_host_time;
+  snapshot.anchor_daq_time = 1'000'000'000'000;
+  snapshot.rate_hz = snapshot.slew_rate_hz = clock_frequency_hz;
+  publisher.publish(snapshot);
+
+  dfmessages::timestamp_t ts = estimator.get_timestamp_estimate();
+  BOOST_CHECK_GE(ts, snapshot.anchor_daq_time);
+  BOOST_CHECK_LT(ts, snapshot.anchor_daq_time + clock_frequency_hz);
+
+  std::atomic<bool> continue_flag{ true };
+  BOOST_CHECK_EQUAL(estimator.wait_for_timestamp(ts + clock_frequency_hz / 100, continue_flag),
+                    timinglibs::TimestampEstimatorBase::kFinished);
+
+  shm_unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/**
+ * @file StrandPool_test.cxx  StrandPool class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/StrandPool.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE StrandPool_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(StrandsKeepTheirOrder)
+{
+  timinglibs::StrandPool pool(4);
+
+  std::mutex order_mutex;
+  std::map<std::string, std::vector<int>> order;
+  std::atomic<int> running_per_strand[3] = { 0, 0, 0 };
+  std::atomic<bool> overlapped{ false };
+
+  for (int i = 0; i < 300; ++i) {
+    int strand = i % 3;
+    std::string strand_name = "device" + std::to_string(strand);
+    pool.post(strand_name, [&, i, strand, strand_name]() {
+      if (running_per_strand[strand]++ != 0) {
+        overlapped = true;
+      }
+      {
+        std::lock_guard<std::mutex> lk(order_mutex);
+        order[strand_name].push_back(i);
+      }
+      --running_per_strand[strand];
+    });
+  }
+  pool.wait_idle();
+
+  BOOST_CHECK(!overlapped);
+  BOOST_CHECK_EQUAL(pool.get_number_of_pending_tasks(), 0);
+  for (auto& [strand_name, indices] : order) {
+    BOOST_REQUIRE_EQUAL(indices.size(), 100);
+    for (size_t j = 1; j < indices.size(); ++j) {
+      BOOST_CHECK_LT(indices[j - 1], indices[j]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SlowStrandDoesNotBlockOthers)
+{
+  timinglibs::StrandPool pool(2);
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> fast_done;
+
+  pool.post("slow", [released]() { released.wait(); });
+  pool.post("slow", []() {});
+  pool.post("fast", [&]() { fast_done.set_value(); });
+
+  // The fast strand runs while the slow one is still stuck
+  BOOST_CHECK(fast_done.get_future().wait_for(10s) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(pool.get_number_of_pending_tasks(), 2);
+
+  release.set_value();
+  pool.wait_idle();
+  BOOST_CHECK_EQUAL(pool.get_number_of_pending_tasks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(FailedTasksAndShutdown)
+{
+  std::atomic<int> n_run{ 0 };
+  {
+    timinglibs::StrandPool pool(1);
+    pool.post("device", []() { throw std::runtime_error("hw error"); });
+    for (int i = 0; i < 10; ++i) {
+      pool.post("device", [&]() { ++n_run; });
+    }
+    // The destructor runs everything that was posted
+  }
+  BOOST_CHECK_EQUAL(n_run.load(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(HigherPriorityOvertakes)
+{
+  timinglibs::StrandPool pool(1);
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> blocking;
+
+  std::vector<std::string> order;
+  pool.post("device", [&, released]() {
+    blocking.set_value();
+    released.wait();
+  });
+  blocking.get_future().wait();
+
+  pool.post("device", [&]() { order.push_back("low"); }, -1);
+  pool.post("device", [&]() { order.push_back("normal0"); });
+  pool.post("device", [&]() { order.push_back("urgent"); }, 1);
+  pool.post("device", [&]() { order.push_back("normal1"); });
+
+  release.set_value();
+  pool.wait_idle();
+
+  std::vector<std::string> expected = { "urgent", "normal0", "normal1", "low" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(UrgentWorkerRunsWhileOthersAreBusy)
+{
+  timinglibs::StrandPool pool(1, "strand-pool", 1, 1);
+  BOOST_CHECK_EQUAL(pool.get_number_of_workers(), 1);
+  BOOST_CHECK_EQUAL(pool.get_number_of_urgent_workers(), 1);
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> normal_done;
+  std::promise<void> urgent_done;
+
+  pool.post("slow", [released]() { released.wait(); });
+  pool.post("other", [&]() { normal_done.set_value(); });
+  pool.post("urgent", [&]() { urgent_done.set_value(); }, 1);
+
+  // Only the urgent task gets past the busy worker
+  BOOST_CHECK(urgent_done.get_future().wait_for(10s) == std::future_status::ready);
+  auto normal_future = normal_done.get_future();
+  BOOST_CHECK(normal_future.wait_for(100ms) == std::future_status::timeout);
+
+  release.set_value();
+  BOOST_CHECK(normal_future.wait_for(10s) == std::future_status::ready);
+  pool.wait_idle();
+}
+
+BOOST_AUTO_TEST_CASE(ShutdownWhileUrgentTaskRuns)
+{
+  std::atomic<int> n_run{ 0 };
+  std::promise<void> release_slow;
+  std::promise<void> release_urgent;
+  auto slow_released = release_slow.get_future().share();
+  auto urgent_released = release_urgent.get_future().share();
+  std::promise<void> slow_started;
+  std::promise<void> urgent_started;
+  std::thread releaser;
+  {
+    timinglibs::StrandPool pool(1, "strand-pool", 1, 1);
+    // keep the regular worker busy, so that the urgent worker takes the urgent task
+    pool.post("slow", [&, slow_released]() {
+      slow_started.set_value();
+      slow_released.wait();
+    });
+    slow_started.get_future().wait();
+    pool.post("device", [&, urgent_released]() {
+      urgent_started.set_value();
+      urgent_released.wait();
+    }, 1);
+    urgent_started.get_future().wait();
+    for (int i = 0; i < 10; ++i) {
+      pool.post("device", [&]() { ++n_run; });
+    }
+    // The regular worker is free again while the pool is stopping and the urgent worker still holds the strand.
+    // Only the regular worker can run the other tasks, so it has to wait for them
+    releaser = std::thread([&]() {
+      std::this_thread::sleep_for(100ms);
+      release_slow.set_value();
+      std::this_thread::sleep_for(100ms);
+      release_urgent.set_value();
+    });
+  }
+  releaser.join();
+  BOOST_CHECK_EQUAL(n_run.load(), 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+/**
+ * @file TimeSyncSourceTracker_test.cxx  TimeSyncSourceTracker class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimeSyncSourceTracker.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TimeSyncSourceTracker_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdint>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const int64_t threshold = 62'500; // 1 ms at 62.5 MHz
+const int64_t period = 100'000'000;  // 100 ms in ns
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SingleSource)
+{
+  timinglibs::TimeSyncSourceTracker tracker(threshold);
+  int64_t now = 0;
+
+  // A lone source is always used, even if it jumps
+  BOOST_CHECK(tracker.add(1, 0, false, 1000, now));
+  for (int i = 0; i < 10; ++i) {
+    now += period;
+    BOOST_CHECK(tracker.add(1, i < 5 ? 10 : 10 * threshold, true, 1000, now));
+  }
+  BOOST_CHECK(!tracker.get_sources().at(1).outlier);
+  BOOST_CHECK_EQUAL(tracker.get_sources().at(1).received, 11);
+  BOOST_CHECK_EQUAL(tracker.get_sources().at(1).rejected, 0);
+}
+
+BOOST_AUTO_TEST_CASE(RejectsMinority)
+{
+  timinglibs::TimeSyncSourceTracker tracker(threshold);
+  int64_t now = 0;
+
+  // Two good sources establish the consensus
+  for (int i = 0; i < 5; ++i) {
+    now += period;
+    BOOST_CHECK(tracker.add(1, 10, true, 1000, now));
+    BOOST_CHECK(tracker.add(2, -10, true, 1000, now));
+  }
+
+  // A third one whose host clock is 5 ms off is never used
+  for (int i = 0; i < 10; ++i) {
+    now += period;
+    BOOST_CHECK(!tracker.add(3, 5 * threshold, true, 1000, now));
+    BOOST_CHECK(tracker.add(1, 10, true, 1000, now));
+    BOOST_CHECK(tracker.add(2, -10, true, 1000, now));
+  }
+  BOOST_CHECK(tracker.get_sources().at(3).outlier);
+  BOOST_CHECK_EQUAL(tracker.get_sources().at(3).rejected, 10);
+  BOOST_CHECK_EQUAL(tracker.get_sources().at(3).offset, 5 * threshold);
+
+  // Once its clock is fixed, it is used again
+  for (int i = 0; i < 10; ++i) {
+    now += period;
+    tracker.add(3, 0, true, 1000, now);
+  }
+  BOOST_CHECK(!tracker.get_sources().at(3).outlier);
+  BOOST_CHECK(tracker.add(3, 0, true, 1000, now));
+}
+
+BOOST_AUTO_TEST_CASE(NoMajority)
+{
+  timinglibs::TimeSyncSourceTracker tracker(threshold);
+  int64_t now = 0;
+
+  // Two sources which disagree: there is no way to tell which is right
+  for (int i = 0; i < 10; ++i) {
+    now += period;
+    BOOST_CHECK(tracker.add(1, -5 * threshold, true, 1000, now));
+    BOOST_CHECK(tracker.add(2, 5 * threshold, true, 1000, now));
+  }
+  BOOST_CHECK(!tracker.get_sources().at(1).outlier);
+  BOOST_CHECK(!tracker.get_sources().at(2).outlier);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+/**
+ * @file TimerWheel_test.cxx  TimerWheel class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/TimerWheel.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TimerWheel_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(ExpiresInOrder)
+{
+  timinglibs::TimerWheel<int> wheel(16);
+  std::vector<int> expired;
+
+  wheel.add(100, 1);
+  wheel.add(5000, 2);
+  wheel.add(2'000'000, 3);
+  BOOST_CHECK_EQUAL(wheel.size(), 3);
+
+  // Nothing is handed out before its expiry, even inside the right slot
+  wheel.advance(99, expired);
+  BOOST_CHECK(expired.empty());
+  BOOST_CHECK_LE(wheel.next_expiry(), 100);
+
+  wheel.advance(100, expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], 1);
+
+  wheel.advance(4999, expired);
+  BOOST_CHECK_EQUAL(expired.size(), 1);
+  wheel.advance(1'000'000, expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 2);
+  BOOST_CHECK_EQUAL(expired[1], 2);
+
+  wheel.advance(3'000'000, expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 3);
+  BOOST_CHECK_EQUAL(expired[2], 3);
+  BOOST_CHECK(wheel.empty());
+}
+
+BOOST_AUTO_TEST_CASE(PastAndOverflow)
+{
+  timinglibs::TimerWheel<int> wheel(1);
+  std::vector<int> expired;
+
+  // Far beyond the range of the wheel levels
+  const dfmessages::timestamp_t far = 1'600'000'000'000'000'000;
+  wheel.add(far, 1);
+  wheel.advance(far - 1, expired);
+  BOOST_CHECK(expired.empty());
+
+  // Already in the past
+  wheel.add(10, 2);
+  wheel.advance(far - 1, expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], 2);
+
+  wheel.advance(far, expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 2);
+  BOOST_CHECK_EQUAL(expired[1], 1);
+}
+
+BOOST_AUTO_TEST_CASE(RandomTimers)
+{
+  timinglibs::TimerWheel<dfmessages::timestamp_t> wheel(64);
+  std::mt19937_64 generator(1234);
+  std::uniform_int_distribution<dfmessages::timestamp_t> delay(0, 1'000'000'000);
+  std::uniform_int_distribution<dfmessages::timestamp_t> step(0, 10'000'000);
+
+  dfmessages::timestamp_t now = 1'000'000'000'000;
+  size_t n_added = 0, n_expired = 0;
+  std::vector<dfmessages::timestamp_t> expired;
+  for (int i = 0; i < 2000; ++i) {
+    for (int j = 0; j < 5; ++j, ++n_added)
+      wheel.add(now + delay(generator), 0);
+    now += step(generator);
+    expired.clear();
+    wheel.advance(now, expired);
+    n_expired += expired.size();
+  }
+  BOOST_CHECK_EQUAL(n_added, n_expired + wheel.size());
+
+  // Check that each timer expires exactly when it should
+  timinglibs::TimerWheel<dfmessages::timestamp_t> checked(64);
+  std::vector<dfmessages::timestamp_t> expiries;
+  for (int i = 0; i < 1000; ++i) {
+    expiries.push_back(now + delay(generator));
+    checked.add(expiries.back(), expiries.back());
+  }
+  std::sort(expiries.begin(), expiries.end());
+  for (auto expiry : expiries) {
+    expired.clear();
+    checked.advance(expiry - 1, expired);
+    for (auto e : expired)
+      BOOST_CHECK_LT(e, expiry);
+    expired.clear();
+    checked.advance(expiry, expired);
+    for (auto e : expired)
+      BOOST_CHECK_EQUAL(e, expiry);
+  }
+  BOOST_CHECK(checked.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
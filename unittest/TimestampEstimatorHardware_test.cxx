@@ -0,0 +1,120 @@
+/**
+ * @file TimestampEstimatorHardware_test.cxx  TimestampEstimatorHardware class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/Clock.hpp"
+#include "timinglibs/TimestampEstimatorHardware.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TimestampEstimatorHardware_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+const dfmessages::timestamp_t daq_start = 1'000'000'000'000;
+
+// A timing endpoint whose clock runs 20 ppm fast, and whose register
+// reads take read_time, the register being latched half way through
+struct FakeEndpoint
+{
+  std::shared_ptr<timinglibs::VirtualClock> clock;
+  std::chrono::nanoseconds read_time{ 10us };
+  bool fail{ false };
+
+  dfmessages::timestamp_t true_timestamp() const
+  {
+    return daq_start + std::llround(clock->steady_time_ns() * 1e-9 * clock_frequency_hz * (1. + 20e-6));
+  }
+
+  dfmessages::timestamp_t read()
+  {
+    if (fail) {
+      throw std::runtime_error("IPbus timeout");
+    }
+    clock->advance(read_time / 2);
+    dfmessages::timestamp_t timestamp = true_timestamp();
+    clock->advance(read_time / 2);
+    return timestamp;
+  }
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(InterpolatesSamples)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(0);
+  FakeEndpoint endpoint{ clock };
+  timinglibs::TimestampEstimatorHardware te([&]() { return endpoint.read(); }, clock_frequency_hz, 0ms, clock);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), dfmessages::TypeDefaults::s_invalid_timestamp);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate_error(), dfmessages::TypeDefaults::s_invalid_timestamp);
+
+  for (int i = 0; i < 100; ++i) {
+    BOOST_CHECK(te.sample());
+    clock->advance(100ms);
+  }
+
+  // Between samples, and well after the last one
+  for (auto step : { 50ms, 5000ms }) {
+    clock->advance(step);
+    int64_t error = static_cast<int64_t>(te.get_timestamp_estimate() - endpoint.true_timestamp());
+    BOOST_CHECK_LT(std::abs(error), 10);
+    BOOST_CHECK_GE(static_cast<int64_t>(te.get_timestamp_estimate_error()), std::abs(error));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DropsSlowAndFailedReads)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(0);
+  FakeEndpoint endpoint{ clock };
+  timinglibs::TimestampEstimatorHardware te([&]() { return endpoint.read(); }, clock_frequency_hz, 0ms, clock);
+
+  for (int i = 0; i < 10; ++i) {
+    BOOST_CHECK(te.sample());
+    clock->advance(100ms);
+  }
+
+  endpoint.read_time = 1ms;
+  BOOST_CHECK(!te.sample());
+  endpoint.read_time = 10us;
+  endpoint.fail = true;
+  BOOST_CHECK(!te.sample());
+  endpoint.fail = false;
+  BOOST_CHECK(te.sample());
+}
+
+BOOST_AUTO_TEST_CASE(SamplingThread)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(0);
+  FakeEndpoint endpoint{ clock, 0us };
+  timinglibs::TimestampEstimatorHardware te([&]() { return endpoint.read(); }, clock_frequency_hz, 100ms, clock);
+
+  // The first sample is taken straight away
+  std::atomic<bool> continue_flag{ true };
+  BOOST_CHECK_EQUAL(te.wait_for_valid_timestamp(continue_flag), timinglibs::TimestampEstimatorBase::kFinished);
+
+  auto target = endpoint.true_timestamp() + clock_frequency_hz;
+  auto done = te.async_wait_for_timestamp(target);
+  while (done.wait_for(1ms) != std::future_status::ready) {
+    clock->advance(10ms);
+  }
+  BOOST_CHECK_EQUAL(done.get(), timinglibs::TimestampEstimatorBase::kFinished);
+  BOOST_CHECK_GE(endpoint.true_timestamp() + 10, target);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
  * received with this code.
  */
 
+#include "timinglibs/Clock.hpp"
 #include "timinglibs/TimestampEstimatorSystem.hpp"
 
 /**
@@ -16,14 +17,19 @@
 #include "boost/test/unit_test.hpp"
 #include <boost/test/tools/old/interface.hpp>
 #include <chrono>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <thread>
 
 BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
 
 BOOST_AUTO_TEST_CASE(Basics)
 {
   const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+  auto clock = std::make_shared<dunedaq::timinglibs::VirtualClock>(1'600'000'000'000'000'000);
   std::atomic<bool> continue_flag{ true };
-  dunedaq::timinglibs::TimestampEstimatorSystem tes(clock_frequency_hz);
+  dunedaq::timinglibs::TimestampEstimatorSystem tes(clock_frequency_hz, clock);
 
   BOOST_CHECK_EQUAL(tes.wait_for_valid_timestamp(continue_flag),
                     dunedaq::timinglibs::TimestampEstimatorBase::kFinished);
@@ -32,9 +38,17 @@ BOOST_AUTO_TEST_CASE(Basics)
   BOOST_CHECK_EQUAL(tes.wait_for_valid_timestamp(do_not_continue_flag),
                     dunedaq::timinglibs::TimestampEstimatorBase::kInterrupted);
 
+  // The timestamp follows the system time of the clock
   dunedaq::dfmessages::timestamp_t ts_now = tes.get_timestamp_estimate();
-  BOOST_CHECK_EQUAL(tes.wait_for_timestamp(ts_now + clock_frequency_hz, continue_flag),
-                    dunedaq::timinglibs::TimestampEstimatorBase::kFinished);
+  BOOST_CHECK_EQUAL(ts_now, 100'000'000'000'000'000);
+
+  auto waiter = std::async(std::launch::async, [&]() {
+    return tes.wait_for_timestamp(ts_now + clock_frequency_hz, continue_flag);
+  });
+  clock->advance(std::chrono::milliseconds(999));
+  BOOST_CHECK(waiter.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+  clock->advance(std::chrono::milliseconds(1));
+  BOOST_CHECK_EQUAL(waiter.get(), dunedaq::timinglibs::TimestampEstimatorBase::kFinished);
 
   ts_now = tes.get_timestamp_estimate();
   BOOST_CHECK_EQUAL(tes.wait_for_timestamp(ts_now + clock_frequency_hz, do_not_continue_flag),
@@ -46,4 +60,79 @@ BOOST_AUTO_TEST_CASE(Basics)
   BOOST_CHECK_GE(ts2, ts1);
 }
 
+BOOST_AUTO_TEST_CASE(FractionalMHz)
+{
+  const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+  dunedaq::timinglibs::TimestampEstimatorSystem tes(clock_frequency_hz);
+
+  BOOST_CHECK_EQUAL(tes.ns_to_ticks(1'000'000'000), clock_frequency_hz);
+  BOOST_CHECK_EQUAL(tes.ns_to_ticks(15), 0);
+  BOOST_CHECK_EQUAL(tes.ns_to_ticks(16), 1);
+  BOOST_CHECK_EQUAL(tes.ticks_to_ns(1), 16);
+
+  // 1.6e18 ns since the epoch: exactly 62.5 ticks per us, and no overflow
+  const uint64_t ns = 1'600'000'000'123'456'789; // NOLINT(build/unsigned)
+  BOOST_CHECK_EQUAL(tes.ns_to_ticks(ns), ns / 16);
+  BOOST_CHECK_GE(tes.ns_to_ticks(tes.ticks_to_ns(ns / 16)), ns / 16);
+
+  auto before = std::chrono::system_clock::now().time_since_epoch();
+  dunedaq::dfmessages::timestamp_t ts = tes.get_timestamp_estimate();
+  auto after = std::chrono::system_clock::now().time_since_epoch();
+  BOOST_CHECK_GE(ts, std::chrono::duration_cast<std::chrono::nanoseconds>(before).count() / 16);
+  BOOST_CHECK_LE(ts, std::chrono::duration_cast<std::chrono::nanoseconds>(after).count() / 16);
+}
+
+BOOST_AUTO_TEST_CASE(Tsc)
+{
+  const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+  dunedaq::timinglibs::TimestampEstimatorSystem tsc_tes(clock_frequency_hz, true);
+  dunedaq::timinglibs::TimestampEstimatorSystem tes(clock_frequency_hz);
+  if (!tsc_tes.is_using_tsc()) {
+    BOOST_TEST_MESSAGE("No invariant TSC, skipping the TSC checks");
+    return;
+  }
+
+  // The two should agree to within the calibration accuracy, here 100 us
+  for (int i = 0; i < 10; ++i) {
+    auto ts = static_cast<int64_t>(tes.get_timestamp_estimate());
+    auto tsc_ts = static_cast<int64_t>(tsc_tes.get_timestamp_estimate());
+    BOOST_CHECK_LT(std::abs(tsc_ts - ts), static_cast<int64_t>(clock_frequency_hz / 10'000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AsyncWaits)
+{
+  const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+  std::future<dunedaq::timinglibs::TimestampEstimatorBase::WaitStatus> late;
+  {
+    dunedaq::timinglibs::TimestampEstimatorSystem tes(clock_frequency_hz);
+
+    dunedaq::dfmessages::timestamp_t target = tes.get_timestamp_estimate() + clock_frequency_hz / 10;
+    auto soon = tes.async_wait_for_timestamp(target);
+    late = tes.async_wait_for_timestamp(target + 100 * clock_frequency_hz);
+
+    std::atomic<int> n_called{ 0 };
+    tes.call_at_timestamp(target, [&](dunedaq::timinglibs::TimestampEstimatorBase::WaitStatus status) {
+      if (status == dunedaq::timinglibs::TimestampEstimatorBase::kFinished)
+        ++n_called;
+    });
+
+    BOOST_REQUIRE(soon.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    BOOST_CHECK_EQUAL(soon.get(), dunedaq::timinglibs::TimestampEstimatorBase::kFinished);
+    BOOST_CHECK_GE(tes.get_timestamp_estimate(), target);
+    BOOST_CHECK(late.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+
+    // The callback for the same timestamp may run just after the promise was fulfilled
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (n_called.load() == 0 && std::chrono::steady_clock::now() < give_up)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    BOOST_CHECK_EQUAL(n_called.load(), 1);
+  }
+
+  // Destroying the estimator interrupts the outstanding waits
+  BOOST_REQUIRE(late.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(late.get(), dunedaq::timinglibs::TimestampEstimatorBase::kInterrupted);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,7 +8,9 @@
 
 #include "appfwk/DAQSink.hpp"
 #include "appfwk/DAQSource.hpp"
+#include "timinglibs/Clock.hpp"
 #include "timinglibs/TimestampEstimator.hpp"
+#include "timinglibs/TimestampEstimatorRegistry.hpp"
 
 /**
  * @brief Name of this test module
@@ -18,14 +20,63 @@
 #include "boost/test/unit_test.hpp"
 
 #include <chrono>
+#include <cmath>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
 
 using namespace dunedaq;
+using namespace std::chrono_literals;
 
 BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
 
+namespace {
+const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
+const int64_t system_start = 1'600'000'000'000'000'000;
+const dfmessages::timestamp_t daq_start = 1'000'000'000'000;
+
+// The DAQ time at system time system_time of a DAQ clock ticking at rate_hz
+dfmessages::timestamp_t
+daq_time_at(int64_t system_time, double rate_hz)
+{
+  return daq_start + std::llround((system_time - system_start) * 1e-9 * rate_hz);
+}
+
+dfmessages::TimeSync
+make_timesync(dfmessages::timestamp_t daq_time, int64_t system_time, dfmessages::run_number_t run_number = 0)
+{
+  dfmessages::TimeSync timesync(daq_time);
+  timesync.system_time = system_time / 1000;
+  timesync.run_number = run_number;
+  return timesync;
+}
+
+// Feed the estimator one TimeSync every period for duration of
+// simulated time, each delivered delivery_lag after it was made
+void
+run_timesyncs(timinglibs::TimestampEstimator& te,
+              timinglibs::VirtualClock& clock,
+              double rate_hz,
+              std::chrono::nanoseconds duration,
+              std::chrono::nanoseconds delivery_lag,
+              std::chrono::nanoseconds period = 100ms)
+{
+  for (std::chrono::nanoseconds elapsed(0); elapsed < duration; elapsed += period) {
+    int64_t made = clock.system_time_ns();
+    clock.advance(delivery_lag);
+    te.add_timesync(make_timesync(daq_time_at(made, rate_hz), made));
+    clock.advance(period - delivery_lag);
+  }
+}
+
+int64_t
+estimate_error(timinglibs::TimestampEstimator& te, timinglibs::VirtualClock& clock, double rate_hz)
+{
+  return static_cast<int64_t>(te.get_timestamp_estimate() - daq_time_at(clock.system_time_ns(), rate_hz));
+}
+} // namespace
+
 /**
  * @brief Initializes the QueueRegistry
  */
@@ -47,16 +98,13 @@ BOOST_TEST_GLOBAL_FIXTURE(DAQSinkDAQSourceTestFixture);
 
 BOOST_AUTO_TEST_CASE(Basics)
 {
-  using namespace std::chrono_literals;
-
   using sink_t = appfwk::DAQSink<dfmessages::TimeSync>;
   using source_t = appfwk::DAQSource<dfmessages::TimeSync>;
   auto sink = std::make_unique<sink_t>("dummy");
   auto source = std::make_unique<source_t>("dummy");
 
-  const uint64_t clock_frequency_hz = 62'500'000; // NOLINT(build/unsigned)
-
-  timinglibs::TimestampEstimator te(source, clock_frequency_hz);
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(source, clock_frequency_hz, clock);
 
   // There's no valid timestamp yet, because no TimeSync messages have
   // been received. We should immediately return with kInterrupted
@@ -65,33 +113,158 @@ BOOST_AUTO_TEST_CASE(Basics)
                     timinglibs::TimestampEstimatorBase::kInterrupted);
 
   std::atomic<bool> continue_flag{ true };
-  dfmessages::timestamp_t initial_ts = 1;
-  sink->push(dfmessages::TimeSync(initial_ts), 10ms);
+  sink->push(make_timesync(daq_start, clock->system_time_ns()), 10ms);
   BOOST_CHECK_EQUAL(te.wait_for_valid_timestamp(continue_flag), timinglibs::TimestampEstimatorBase::kFinished);
 
-  dfmessages::timestamp_t ts_now = te.get_timestamp_estimate();
-
-  // Check that the timestamp has advanced a bit from the initial TimeSync, but not by "too much".
-  auto too_much = clock_frequency_hz / 10; // 100 ms
-  BOOST_CHECK_GE(ts_now, initial_ts);
-  BOOST_CHECK_LT(ts_now, initial_ts + too_much);
+  // No time has passed since the TimeSync, and the estimate only moves with the clock
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start);
+  clock->advance(100ms);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start + clock_frequency_hz / 10);
 
-  BOOST_CHECK_EQUAL(te.wait_for_timestamp(ts_now + clock_frequency_hz, continue_flag),
-                    timinglibs::TimestampEstimatorBase::kFinished);
+  // A wait ends as soon as the clock reaches its timestamp
+  dfmessages::timestamp_t ts_now = te.get_timestamp_estimate();
+  auto waiter = std::async(std::launch::async, [&]() {
+    return te.wait_for_timestamp(ts_now + clock_frequency_hz, continue_flag);
+  });
+  clock->advance(500ms);
+  BOOST_CHECK(waiter.wait_for(0ms) == std::future_status::timeout);
+  clock->advance(500ms);
+  BOOST_CHECK_EQUAL(waiter.get(), timinglibs::TimestampEstimatorBase::kFinished);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), ts_now + clock_frequency_hz);
 
   ts_now = te.get_timestamp_estimate();
   BOOST_CHECK_EQUAL(te.wait_for_timestamp(ts_now + clock_frequency_hz, do_not_continue_flag),
                     timinglibs::TimestampEstimatorBase::kInterrupted);
+}
+
+BOOST_AUTO_TEST_CASE(SharedEstimators)
+{
+  auto& registry = timinglibs::TimestampEstimatorRegistry::get();
+
+  auto first = registry.get_estimator("dummy", clock_frequency_hz);
+  auto second = registry.get_estimator("dummy", clock_frequency_hz);
+  BOOST_CHECK_EQUAL(first.get(), second.get());
+  BOOST_CHECK_EQUAL(registry.get_number_of_estimators(), 1);
+
+  // The estimator lives on until its last user detaches
+  first.reset();
+  BOOST_CHECK_EQUAL(registry.get_number_of_estimators(), 1);
+  second.reset();
+  BOOST_CHECK_EQUAL(registry.get_number_of_estimators(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(FollowsDrift)
+{
+  // A DAQ clock running 50 ppm fast with respect to the host clock,
+  // for a minute of simulated time
+  const double true_rate = clock_frequency_hz * (1. + 50e-6);
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+
+  run_timesyncs(te, *clock, true_rate, 60s, 0ms);
+  int64_t error = estimate_error(te, *clock, true_rate);
+  // The TimeSync system times only have us resolution
+  BOOST_CHECK_LT(std::abs(error), 200);
+  BOOST_CHECK_GE(static_cast<int64_t>(te.get_timestamp_estimate_error()), std::abs(error));
 
-  // Check that the timestamp doesn't go backwards
-  dfmessages::timestamp_t ts1 = te.get_timestamp_estimate();
-  BOOST_CHECK_GE(ts1, initial_ts);
-  dfmessages::timestamp_t ts2 = te.get_timestamp_estimate();
-  BOOST_CHECK_GE(ts2, ts1);
-  // Check that the timestamp advances
-  std::this_thread::sleep_for(10ms);
-  dfmessages::timestamp_t ts3 = te.get_timestamp_estimate();
-  BOOST_CHECK_GT(ts3, ts2);
+  // Extrapolating at the nominal rate would be 31250 ticks off after 10 s
+  clock->advance(10s);
+  error = estimate_error(te, *clock, true_rate);
+  BOOST_CHECK_LT(std::abs(error), 1000);
+  BOOST_CHECK_GE(static_cast<int64_t>(te.get_timestamp_estimate_error()), std::abs(error));
+}
+
+BOOST_AUTO_TEST_CASE(LateTimeSyncs)
+{
+  // TimeSyncs delivered a quarter of a second after they were made
+  // carry their own system time, so the estimate doesn't lag behind
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+
+  run_timesyncs(te, *clock, clock_frequency_hz, 30s, 250ms, 1s);
+  BOOST_CHECK_LT(std::abs(estimate_error(te, *clock, clock_frequency_hz)), 200);
+
+  // A TimeSync from the future, according to our system clock, is rejected
+  dfmessages::timestamp_t before = te.get_timestamp_estimate();
+  te.add_timesync(make_timesync(before + clock_frequency_hz, clock->system_time_ns() + 1'000'000'000));
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), before);
+}
+
+BOOST_AUTO_TEST_CASE(SystemClockSteps)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+  run_timesyncs(te, *clock, clock_frequency_hz, 5s, 0ms);
+
+  // Between TimeSyncs the estimate follows the steady time, not steps of the system time
+  dfmessages::timestamp_t before = te.get_timestamp_estimate();
+  clock->step_system_time(-2s);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), before);
+  clock->advance(50ms);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), before + clock_frequency_hz / 20);
+}
+
+BOOST_AUTO_TEST_CASE(AsyncWaits)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+  te.add_timesync(make_timesync(daq_start, clock->system_time_ns()));
+
+  auto soon = te.async_wait_for_timestamp(daq_start + clock_frequency_hz);
+  auto late = te.async_wait_for_timestamp(daq_start + 1000 * clock_frequency_hz);
+
+  clock->advance(999ms);
+  BOOST_CHECK(soon.wait_for(0ms) == std::future_status::timeout);
+  clock->advance(1ms);
+  BOOST_CHECK_EQUAL(soon.get(), timinglibs::TimestampEstimatorBase::kFinished);
+
+  // Simulated hours take no time at all
+  clock->advance(std::chrono::hours(1));
+  BOOST_CHECK_EQUAL(late.get(), timinglibs::TimestampEstimatorBase::kFinished);
+}
+
+BOOST_AUTO_TEST_CASE(RunNumbers)
+{
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+  te.set_run_number(2);
+
+  // A TimeSync from another run is dropped
+  te.add_timesync(make_timesync(daq_start, clock->system_time_ns(), 1));
+  BOOST_CHECK_EQUAL(te.get_discarded_timesyncs(), 1);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), dfmessages::TypeDefaults::s_invalid_timestamp);
+
+  // One without a run number is used
+  te.add_timesync(make_timesync(daq_start, clock->system_time_ns(), 0));
+  BOOST_CHECK_EQUAL(te.get_discarded_timesyncs(), 1);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start);
+
+  // So is one from the current run
+  clock->advance(100ms);
+  te.add_timesync(make_timesync(daq_start + clock_frequency_hz / 10, clock->system_time_ns(), 2));
+  BOOST_CHECK_EQUAL(te.get_discarded_timesyncs(), 1);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start + clock_frequency_hz / 10);
+
+  // An estimator kept for the next run still has its estimate, before any TimeSync of that run
+  te.set_run_number(3);
+  clock->advance(100ms);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start + clock_frequency_hz / 5);
+  std::atomic<bool> continue_flag{ true };
+  BOOST_CHECK_EQUAL(te.wait_for_valid_timestamp(continue_flag), timinglibs::TimestampEstimatorBase::kFinished);
+  te.add_timesync(make_timesync(daq_start + clock_frequency_hz / 5, clock->system_time_ns(), 2));
+  BOOST_CHECK_EQUAL(te.get_discarded_timesyncs(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(AnyRunNumber)
+{
+  // With a run number of 0, TimeSyncs from any run are used
+  auto clock = std::make_shared<timinglibs::VirtualClock>(system_start);
+  timinglibs::TimestampEstimator te(clock_frequency_hz, clock);
+  te.add_timesync(make_timesync(daq_start, clock->system_time_ns(), 7));
+  clock->advance(100ms);
+  te.add_timesync(make_timesync(daq_start + clock_frequency_hz / 10, clock->system_time_ns(), 8));
+  BOOST_CHECK_EQUAL(te.get_discarded_timesyncs(), 0);
+  BOOST_CHECK_EQUAL(te.get_timestamp_estimate(), daq_start + clock_frequency_hz / 10);
 }
 
 BOOST_AUTO_TEST_SUITE_END()